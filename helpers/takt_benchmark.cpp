@@ -0,0 +1,306 @@
+// Host benchmark of the TAKT path: string-keyed signal engine, std::bitset registers
+// and the native-width W_Machine core
+//
+// Build and run from the repository root:
+//   g++ -std=gnu++17 -O2 -Iinclude helpers/takt_benchmark.cpp src/w_machine.cpp src/w_trace.cpp src/w_history.cpp -o takt_benchmark
+//   ./takt_benchmark
+//
+// All engines run the same microprogram (select the signals of one step, then TAKT).
+// The "string" engine is the signal handling W_Local used before the Signal enum:
+// names turned into std::string on every press, a std::vector queue, hashed dispatch
+// and conflict lookups. The "bitset" engine already selects signals through masks but
+// keeps the registers in std::bitset with ripple-carry IL/ODE and pow()-based
+// conversions. The "native" engine is the current W_Machine.
+//
+// The final states only match for the default geometry; add e.g.
+// -DW_ADDRESS_BITS=8 -DW_WORD_BITS=11 to measure the native core of a wider machine.
+
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <bitset>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+#include "w_machine.h"
+
+// ================================ String engine ================================
+
+class StringMachine
+{
+    using _5Bit = std::bitset<5>;
+    using _8Bit = std::bitset<8>;
+
+    _5Bit busA;
+    _8Bit busS;
+    _8Bit JAML, AK, S, I;
+    _5Bit A, L;
+    _8Bit PaO[32];
+
+    std::unordered_map<std::string, bool> signal = {
+        {"IL", false}, {"WEL", false}, {"WYL", false}, {"WYAD", false},
+        {"WEI", false}, {"WEAK", false}, {"DOD", false}, {"ODE", false},
+        {"PRZEP", false}, {"WYAK", false}, {"WEJA", false}, {"WEA", false},
+        {"CZYT", false}, {"PISZ", false}, {"WES", false}, {"WYS", false}
+    };
+
+    std::vector<std::string> nextLineSignals;
+
+    using CommandFunction = void (StringMachine::*)();
+    static const std::unordered_map<std::string, CommandFunction> signalMap;
+    static const std::unordered_map<std::string, std::vector<std::string>> signalConflicts;
+
+    template<size_t N>
+    uint8_t binaryTo_uint8_t(std::bitset<N> number)
+    {
+        uint8_t result = 0;
+        if(!number.none()){
+            for(size_t i = 0; i < N; i++){
+                result += number[i] * std::pow(2, i);
+            }
+        }
+        return result;
+    }
+
+    void il()    { _5Bit one("00001"); while(one != 0){ _5Bit carry = L & one; L ^= one; one = carry << 1; } }
+    void wel()   { L = busA; }
+    void wyl()   { busA = L; }
+    void wyad()  { for(int i = 0; i < 5; i++) busA[i] = I[i]; }
+    void wei()   { I = busS; }
+    void weak()  { AK = JAML; }
+    void dod()   { AK |= JAML; }
+    void ode()   { _8Bit b = JAML; while(b.any()){ _8Bit borrow = ~AK & b; AK = AK ^ b; b = borrow << 1; } }
+    void przep() { AK = busS; }
+    void wyak()  { busS = AK; }
+    void weja()  { JAML = busS; }
+    void wea()   { A = busA; }
+    void czyt()  { S = PaO[binaryTo_uint8_t(A)]; }
+    void pisz()  { PaO[binaryTo_uint8_t(A)] = S; }
+    void wes()   { S = busS; }
+    void wys()   { busS = S; }
+
+    bool isSignalValid(const std::string &newSignal)
+    {
+        auto conflictIt = signalConflicts.find(newSignal);
+        if (conflictIt == signalConflicts.end()) return true;
+        for (const auto& existingSignal : nextLineSignals)
+            for (const auto& conflictSignal : conflictIt->second)
+                if (existingSignal == conflictSignal) return false;
+        return true;
+    }
+
+public:
+    void press(const char *button)
+    {
+        std::string buttonStr(button);
+
+        if(buttonStr == "TAKT"){
+            for (const auto& name : nextLineSignals) {
+                auto it = signalMap.find(name);
+                if (it != signalMap.end()) (this->*(it->second))();
+            }
+            for(auto &s : signal) s.second = false;
+            nextLineSignals.clear();
+            return;
+        }
+
+        auto itSignal = std::find(nextLineSignals.begin(), nextLineSignals.end(), buttonStr);
+        if(itSignal != nextLineSignals.end()){
+            nextLineSignals.erase(itSignal);
+            signal[buttonStr] = false;
+        }
+        else if(isSignalValid(buttonStr)){
+            nextLineSignals.push_back(buttonStr);
+            signal[buttonStr] = true;
+        }
+    }
+
+    void load(uint8_t address, uint8_t value) { PaO[address] = _8Bit(value); }
+
+    unsigned checksum() { return binaryTo_uint8_t(AK) << 16 | binaryTo_uint8_t(L) << 8 | binaryTo_uint8_t(S); }
+};
+
+const std::unordered_map<std::string, StringMachine::CommandFunction> StringMachine::signalMap = {
+    {"IL", &StringMachine::il}, {"WEL", &StringMachine::wel}, {"WYL", &StringMachine::wyl},
+    {"WYAD", &StringMachine::wyad}, {"WEI", &StringMachine::wei}, {"WEAK", &StringMachine::weak},
+    {"DOD", &StringMachine::dod}, {"ODE", &StringMachine::ode}, {"PRZEP", &StringMachine::przep},
+    {"WYAK", &StringMachine::wyak}, {"WEJA", &StringMachine::weja}, {"WEA", &StringMachine::wea},
+    {"CZYT", &StringMachine::czyt}, {"PISZ", &StringMachine::pisz}, {"WES", &StringMachine::wes},
+    {"WYS", &StringMachine::wys}
+};
+
+const std::unordered_map<std::string, std::vector<std::string>> StringMachine::signalConflicts = {
+    {"CZYT", {"PISZ"}}, {"PISZ", {"CZYT"}}, {"WYAK", {"WYS"}}, {"WYS", {"WYAK"}},
+    {"IL", {"WEL"}}, {"WEL", {"IL"}}, {"DOD", {"ODE", "PRZEP"}}, {"ODE", {"DOD", "PRZEP"}},
+    {"PRZEP", {"DOD", "ODE"}}, {"WYL", {"WYAD"}}, {"WYAD", {"WYL"}}
+};
+
+// ================================ Bitset engine ================================
+
+class BitsetMachine
+{
+    using _5Bit = std::bitset<5>;
+    using _8Bit = std::bitset<8>;
+
+    _5Bit busA;
+    _8Bit busS;
+    _8Bit JAML, AK, S, I;
+    _5Bit A, L;
+    _8Bit PaO[32];
+
+    SignalMask selected = 0;
+    Signal order[Signals::COUNT] = {};
+    uint8_t orderCount = 0;
+    uint8_t changedRegisters = 0;
+
+    using CommandFunction = void (BitsetMachine::*)();
+    static const CommandFunction COMMANDS[Signals::COUNT];
+
+    template<size_t N>
+    static uint8_t binaryTo_uint8_t(const std::bitset<N> &number)
+    {
+        uint8_t result = 0;
+        if(!number.none()){
+            for(size_t i = 0; i < N; i++){
+                result += number[i] * std::pow(2, i);
+            }
+        }
+        return result;
+    }
+
+    template<size_t N>
+    void write(uint8_t reg, std::bitset<N> &target, const std::bitset<N> &value)
+    {
+        if(target != value){ target = value; changedRegisters |= 1 << reg; }
+    }
+
+    void il()    { _5Bit r = L, one("00001"); while(one != 0){ _5Bit carry = r & one; r ^= one; one = carry << 1; } write(0, L, r); }
+    void wel()   { write(0, L, busA); }
+    void wyl()   { busA = L; }
+    void wyad()  { _5Bit a; for(int i = 0; i < 5; i++) a[i] = I[i]; busA = a; }
+    void wei()   { write(1, I, busS); }
+    void weak()  { write(2, AK, JAML); }
+    void dod()   { write(2, AK, AK | JAML); }
+    void ode()   { _8Bit r = AK, b = JAML; while(b.any()){ _8Bit borrow = ~r & b; r = r ^ b; b = borrow << 1; } write(2, AK, r); }
+    void przep() { write(2, AK, busS); }
+    void wyak()  { busS = AK; }
+    void weja()  { write(5, JAML, busS); }
+    void wea()   { write(3, A, busA); }
+    void czyt()  { write(4, S, PaO[binaryTo_uint8_t(A)]); }
+    void pisz()  { PaO[binaryTo_uint8_t(A)] = S; }
+    void wes()   { write(4, S, busS); }
+    void wys()   { busS = S; }
+
+public:
+    void toggleSignal(Signal signal)
+    {
+        SignalMask bit = Signals::bit(signal);
+        if(selected & bit){
+            selected &= ~bit;
+            uint8_t n = 0;
+            while(order[n] != signal) n++;
+            for(; n + 1 < orderCount; n++) order[n] = order[n + 1];
+            orderCount--;
+        }
+        else if(!(Signals::CONFLICTS[static_cast<uint8_t>(signal)] & selected)){
+            selected |= bit;
+            order[orderCount++] = signal;
+        }
+    }
+
+    void takt()
+    {
+        for(uint8_t n = 0; n < orderCount; n++) (this->*COMMANDS[static_cast<uint8_t>(order[n])])();
+        selected = 0;
+        orderCount = 0;
+    }
+
+    void load(uint8_t address, uint8_t value) { PaO[address] = _8Bit(value); }
+
+    unsigned checksum() { return binaryTo_uint8_t(AK) << 16 | binaryTo_uint8_t(L) << 8 | binaryTo_uint8_t(S); }
+};
+
+const BitsetMachine::CommandFunction BitsetMachine::COMMANDS[Signals::COUNT] = {
+    &BitsetMachine::il, &BitsetMachine::wel, &BitsetMachine::wyl, &BitsetMachine::wyad,
+    &BitsetMachine::wei, &BitsetMachine::weak, &BitsetMachine::dod, &BitsetMachine::ode,
+    &BitsetMachine::przep, &BitsetMachine::wyak, &BitsetMachine::weja, &BitsetMachine::wea,
+    &BitsetMachine::czyt, &BitsetMachine::pisz, &BitsetMachine::wes, &BitsetMachine::wys
+};
+
+// ================================== Workload ===================================
+
+// One step = the signals selected before a TAKT (fetch + execute of ODE/POB style instructions).
+// DOD is left out because it was a bitwise OR before the native ALU, so the final states
+// of the three engines can be compared.
+static const std::vector<std::vector<const char*>> PROGRAM = {
+    {"WYL", "WEA"},
+    {"CZYT", "WYS", "WEI", "IL"},
+    {"WYAD", "WEA"},
+    {"CZYT", "WYS", "WEJA", "ODE"},
+    {"WYL", "WEA"},
+    {"CZYT", "WYS", "WEI", "IL"},
+    {"WYAD", "WEA", "WYL"},     // WYL conflicts with WYAD and is rejected
+    {"CZYT", "WYS", "WEJA", "WEAK"},
+};
+
+static const long TAKTS = 2000000;
+
+template<typename F>
+static double measure(const char *label, F step)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (long n = 0; n < TAKTS; n++) {
+        step(n % PROGRAM.size());
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double taktsPerSecond = TAKTS / seconds;
+
+    printf("%-8s %10.0f takts/s  (%.1f ns/takt)\n", label, taktsPerSecond, 1e9 * seconds / TAKTS);
+    return taktsPerSecond;
+}
+
+int main()
+{
+    // The mask engine gets the Signal of each button up front, like HumanInterface::BUTTONS
+    std::vector<std::vector<Signal>> program;
+    for (const auto &step : PROGRAM) {
+        program.emplace_back();
+        for (const char *name : step) program.back().push_back(Signals::fromName(name));
+    }
+
+    StringMachine strings;
+    BitsetMachine bitsets;
+    W_Machine native;
+
+    // The reference engines model the default 32-word machine
+    for (unsigned address = 0; address < 32; address++) {
+        strings.load(address, address * 7 + 1);
+        bitsets.load(address, address * 7 + 1);
+        native.setMemory(address, address * 7 + 1);
+    }
+
+    double stringRate = measure("string", [&](size_t s) {
+        for (const char *name : PROGRAM[s]) strings.press(name);
+        strings.press("TAKT");
+    });
+
+    double bitsetRate = measure("bitset", [&](size_t s) {
+        for (Signal signal : program[s]) bitsets.toggleSignal(signal);
+        bitsets.takt();
+    });
+
+    double nativeRate = measure("native", [&](size_t s) {
+        for (Signal signal : program[s]) native.toggleSignal(signal);
+        native.takt();
+        native.takeChanges();
+    });
+
+    unsigned nativeChecksum = native.getRegister(W_Machine::regAK) << 16 | native.getRegister(W_Machine::regL) << 8 | native.getRegister(W_Machine::regS);
+
+    printf("native vs string %.1fx, native vs bitset %.1fx\n", nativeRate / stringRate, nativeRate / bitsetRate);
+    printf("final state %06x / %06x / %06x\n", strings.checksum(), bitsets.checksum(), nativeChecksum);
+
+    return 0;
+}
@@ -0,0 +1,189 @@
+// Host benchmark of the WebSocket field dispatch: the String comparison chain
+// W_Server used before Protocol::fieldByName, the perfect-hash table and the binary
+// FIELD frame
+//
+// Build and run from the repository root:
+//   g++ -std=gnu++17 -O2 -Iinclude helpers/ws_dispatch_benchmark.cpp src/w_protocol.cpp -o ws_dispatch_benchmark
+//   ./ws_dispatch_benchmark
+//
+// The stream is a recording of the "reg-update" messages the web app sends while
+// a student runs the fetch and DOD steps by hand. ArduinoJson is not available on
+// the host, so "field" and "value" are cut out of the text by one small scanner
+// shared by the JSON engines; the benchmark measures what follows the parse. The
+// "chain" engine copies the 512-byte document into the handler like the old by-value
+// StaticJsonDocument<512> parameter, walks the comparisons in the old order and
+// formats the two log lines of the matching branch (into a buffer instead of Serial).
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "w_protocol.h"
+
+// ============================== Recorded stream ==============================
+
+static const char *const STREAM[] = {
+    R"({"type":"reg-update","field":"czyt","value":true})",
+    R"({"type":"reg-update","field":"wys","value":true})",
+    R"({"type":"reg-update","field":"wei","value":true})",
+    R"({"type":"reg-update","field":"il","value":true})",
+    R"({"type":"reg-update","field":"s","value":37})",
+    R"({"type":"reg-update","field":"busS","value":true})",
+    R"({"type":"reg-update","field":"i","value":37})",
+    R"({"type":"reg-update","field":"c","value":1})",
+    R"({"type":"reg-update","field":"czyt","value":false})",
+    R"({"type":"reg-update","field":"wys","value":false})",
+    R"({"type":"reg-update","field":"wei","value":false})",
+    R"({"type":"reg-update","field":"il","value":false})",
+    R"({"type":"reg-update","field":"busS","value":false})",
+    R"({"type":"reg-update","field":"wyad","value":true})",
+    R"({"type":"reg-update","field":"wea","value":true})",
+    R"({"type":"reg-update","field":"busA","value":true})",
+    R"({"type":"reg-update","field":"a","value":5})",
+    R"({"type":"reg-update","field":"wyad","value":false})",
+    R"({"type":"reg-update","field":"wea","value":false})",
+    R"({"type":"reg-update","field":"busA","value":false})",
+    R"({"type":"reg-update","field":"czyt","value":true})",
+    R"({"type":"reg-update","field":"wys","value":true})",
+    R"({"type":"reg-update","field":"weja","value":true})",
+    R"({"type":"reg-update","field":"dod","value":true})",
+    R"({"type":"reg-update","field":"wyl","value":true})",
+    R"({"type":"reg-update","field":"wea","value":true})",
+    R"({"type":"reg-update","field":"acc","value":42})",
+    R"({"type":"reg-update","field":"stop","value":false})",
+};
+
+constexpr size_t STREAM_LENGTH = sizeof(STREAM) / sizeof(STREAM[0]);
+
+// Field name and value of a recorded message
+struct Message {
+    char field[16];
+    int value;
+};
+
+static Message scan(const char *json)
+{
+    Message message = {};
+    const char *field = strstr(json, "\"field\":\"") + 9;
+    size_t length = strchr(field, '"') - field;
+    memcpy(message.field, field, length);
+
+    const char *value = strstr(json, "\"value\":") + 8;
+    message.value = (*value == 't') ? 1 : (*value == 'f') ? 0 : atoi(value);
+    return message;
+}
+
+// Drawn state, so the compiler keeps every dispatch
+static int sink[64];
+static char logLine[96];
+
+// ================================ Chain engine ================================
+
+struct Document {
+    char pool[512];
+    Message message;
+};
+
+static void chain(Document doc)
+{
+    static const char *const ORDER[] = {
+        "acc", "a", "s", "c", "i", "addrs", "il", "wel", "wyl", "wyad", "wei", "weak",
+        "dod", "ode", "przep", "weja", "wyak", "wea", "czyt", "pisz", "wes", "wys",
+        "busA", "busS", "stop"
+    };
+
+    std::string field = doc.message.field;
+    int intValue = doc.message.value;
+
+    for (size_t n = 0; n < sizeof(ORDER) / sizeof(ORDER[0]); n++) {
+        if (field == ORDER[n]) {
+            snprintf(logLine, sizeof(logLine), "[W_SERVER]: ");
+            snprintf(logLine, sizeof(logLine), "Partial update: %s = %d\n", ORDER[n], intValue);
+            sink[n] = intValue;
+            return;
+        }
+    }
+}
+
+// ================================ Table engine ================================
+
+static void table(const Message &message)
+{
+    Protocol::Field field;
+    if (Protocol::fieldByName(message.field, field)) {
+        sink[static_cast<uint8_t>(field) & 63] = message.value;
+    }
+}
+
+// ================================ Binary engine ===============================
+
+static void binary(const uint8_t *frame, size_t length)
+{
+    Protocol::Reader reader(frame + 1, length - 1);
+    Protocol::Field field;
+    uint16_t value;
+    if (Protocol::decodeField(reader, field, value)) {
+        sink[static_cast<uint8_t>(field) & 63] = value;
+    }
+}
+
+// ================================= Harness ===================================
+
+template <typename Engine>
+static double measure(const char *label, Engine engine)
+{
+    constexpr size_t ROUNDS = 200000;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < ROUNDS; round++) {
+        for (size_t n = 0; n < STREAM_LENGTH; n++) engine(n);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double rate = ROUNDS * STREAM_LENGTH / seconds;
+    printf("%-8s %10.0f messages/s  (%.1f ns/message)\n", label, rate, 1e9 / rate);
+    return rate;
+}
+
+int main()
+{
+    std::vector<Message> messages;
+    std::vector<std::vector<uint8_t>> frames;
+
+    for (const char *json : STREAM) {
+        Message message = scan(json);
+        messages.push_back(message);
+
+        Protocol::Field field;
+        if (!Protocol::fieldByName(message.field, field)) {
+            printf("unknown field %s\n", message.field);
+            return 1;
+        }
+        frames.push_back({static_cast<uint8_t>(Protocol::Opcode::FIELD), static_cast<uint8_t>(field),
+                          static_cast<uint8_t>(message.value & 0xFF), static_cast<uint8_t>(message.value >> 8)});
+    }
+
+    double chainRate = measure("chain", [&](size_t n) {
+        Document doc;
+        doc.message = scan(STREAM[n]);
+        chain(doc);
+    });
+
+    double tableRate = measure("table", [&](size_t n) {
+        table(scan(STREAM[n]));
+    });
+
+    double binaryRate = measure("binary", [&](size_t n) {
+        binary(frames[n].data(), frames[n].size());
+    });
+
+    size_t jsonBytes = 0;
+    for (const char *json : STREAM) jsonBytes += strlen(json);
+
+    printf("table vs chain %.1fx, binary vs chain %.1fx\n", tableRate / chainRate, binaryRate / chainRate);
+    printf("stream: %zu bytes as JSON, %zu bytes as FIELD frames\n", jsonBytes, STREAM_LENGTH * 4);
+    return 0;
+}
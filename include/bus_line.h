@@ -12,9 +12,6 @@
  * @date 2025
  */
 class BusLine : public LedElement {
-    private:
-        int length = 0;    ///< Number of LEDs in the bus line
-        int channel;
     public:
         /**
          * @brief Default constructor
@@ -24,28 +21,16 @@ class BusLine : public LedElement {
         BusLine();
   
         /**
-         * @brief Constructs a BusLine object for channel 0 using the specified NeoPixelBus strip.
+         * @brief Constructs a BusLine object on the specified strip.
          *
-         * Initializes a BusLine instance that controls a segment of an LED strip using the NeoEsp32Rmt0Ws2812xMethod.
+         * Initializes a BusLine instance that controls a segment of an LED strip through its FrameBuffer.
          *
-         * @param strip0 Pointer to the NeoPixelBus object representing the LED strip (channel 0).
+         * @param frame Pointer to the FrameBuffer of the LED strip.
          * @param startIndex The starting index of the LED segment controlled by this BusLine.
          * @param length The number of LEDs in the segment.
          * @param color The color to be used for the LEDs in this BusLine.
          */
-        BusLine(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt0Ws2812xMethod>* strip0, int startIndex, int length, RgbColor color);
-        
-        /**
-         * @brief Constructs a BusLine object for channel 1 using the specified NeoPixelBus strip.
-         *
-         * Initializes a BusLine instance that controls a segment of an LED strip using the NeoEsp32Rmt0Ws2812xMethod.
-         *
-         * @param strip1 Pointer to the NeoPixelBus object representing the LED strip (channel 1).
-         * @param startIndex The starting index of the LED segment controlled by this BusLine.
-         * @param length The number of LEDs in the segment.
-         * @param color The color to be used for the LEDs in this BusLine.
-         */
-        BusLine(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt1Ws2812xMethod>* strip1, int startIndex, int length, RgbColor color);
+        BusLine(FrameBuffer *frame, int startIndex, int length, PaletteIndex color);
 
         /**
          * @brief Turn the bus line on or off
@@ -53,4 +38,8 @@ class BusLine : public LedElement {
          * @param choice true to turn on (set to color), false to turn off (set to black)
          */
         void turnOnLine(bool choice);
+
+    protected:
+        /** @brief Fill the line with its color (state 1) or turn it off (state 0) */
+        void render(uint32_t state) override;
 };
\ No newline at end of file
@@ -4,11 +4,13 @@
 #include "signal_line.h"
 #include "bus_line.h"
 #include "pao_display_line.h"
+#include "led_layout.h"
 #include "pins.h"
+#include "frame_buffer.h"
 #include <unordered_map>
-
-#define LED_COUNT_R 1000  ///< Maximum LED count for the right LED strip
-#define LED_COUNT_L 1000  ///< Maximum LED count for the left LED strip
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
 
 /**
  * @enum DisplayElement
@@ -20,12 +22,32 @@ enum DisplayElement {
     BUS_LINE     
 };
 
+/**
+ * @struct FrameStats
+ * @brief Counters describing how many strip frames were pushed to the hardware
+ * 
+ * Every refreshDisplay() call produces one frame per strip. A frame is either published
+ * to the LED output task (the strip changed) or skipped (nothing changed since the last
+ * frame). Frames published faster than the output task can send them are merged, so
+ * framesSent only counts frames that really went out with Show().
+ */
+struct FrameStats {
+    uint32_t framesSent     = 0;    ///< Number of strip frames sent to the RMT channels
+    uint32_t framesSkipped  = 0;    ///< Number of strip frames skipped because nothing changed
+    uint64_t bytesSent      = 0;    ///< Pixel data bytes sent over all strip frames
+    uint32_t averageBytesPerFrame = 0; ///< bytesSent / framesSent (strip frames only send the changed prefix)
+    uint32_t lastFrameMicros = 0;   ///< Transmission time of the last frame (all strips), in microseconds
+    uint32_t maxFrameMicros  = 0;   ///< Longest transmission time seen so far, in microseconds
+    uint32_t queueDepth      = 0;   ///< Published frames not yet picked up by the output task
+    uint32_t maxQueueDepth   = 0;   ///< Highest queueDepth seen so far
+};
+
 /**
  * @file display_manager.h
  * @brief Central manager for all LED displays and signal lines
  * 
- * Coordinates control of two NeoPixel LED strips (left and right) containing multiple
- * display types:
+ * Coordinates control of the NeoPixel LED output segments listed in LedLayout::OUTPUTS
+ * (by default the left and right strip) containing multiple display types:
  * @li **Three-Digit Displays** - For showing accumulator, address, stack, counter, instruction
  * @li **Signal Lines** - For indicating machine signal states
  * @li **Bus Lines** - For showing data bus activity
@@ -33,13 +55,31 @@ enum DisplayElement {
  * 
  * Provides centralized color management, animation control, and display refresh capabilities.
  * 
+ * Display elements only write into per-strip back buffers (FrameBuffer). refreshDisplay()
+ * publishes changed back buffers into front buffers and wakes the LED output task, which
+ * runs on its own core and is the only code that touches the NeoPixelBus strips. The
+ * Arduino loop therefore never waits for an RMT transmission to finish.
+ * 
  * @author Bartosz Faruga / MrRooby
  * @date 2025
  */
 class DisplayManager {
 private:
-    NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt0Ws2812xMethod> *stripR;  ///< NeoPixelBus controller for the right LED strip (RMT Channel 0)
-    NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt1Ws2812xMethod> *stripL;  ///< NeoPixelBus controller for the left LED strip (RMT Channel 1)
+    using LedStrip = NeoPixelBus<NeoGrbFeature, NeoEsp32RmtNWs2812xMethod>;
+
+    LedStrip *strips[LedLayout::OUTPUT_COUNT] = {};                 ///< NeoPixelBus controllers, one per output segment (only used to set up the RMT channel from LedLayout::OUTPUTS)
+
+    uint8_t *wire[LedLayout::OUTPUT_COUNT] = {};                    ///< G, R, B data handed to the RMT channels (owned by the output task)
+    FrameBuffer *frames[LedLayout::OUTPUT_COUNT] = {};              ///< Back buffers (written by the display elements)
+    FrameBuffer *fronts[LedLayout::OUTPUT_COUNT] = {};              ///< Front buffers (read by the output task)
+
+    static const BaseType_t OUTPUT_TASK_CORE       = 0;             ///< Core of the LED output task (the Arduino loop runs on core 1)
+    static const UBaseType_t OUTPUT_TASK_PRIORITY  = 2;             ///< Priority of the LED output task
+    static const uint32_t OUTPUT_TASK_STACK_SIZE   = 4096;          ///< Stack size of the LED output task in bytes
+    static const unsigned long LATCH_MICROS        = 300;           ///< WS2812 reset time between two frames in microseconds
+
+    TaskHandle_t outputTaskHandle = nullptr;                        ///< LED output task
+    SemaphoreHandle_t frameMutex  = nullptr;                        ///< Guards the front buffers and frameStats
     
     const int timeBetweenAnimationFramesMilliseconds = 200;         ///< Time interval between animation frames in milliseconds
     unsigned long lastUpdate = 0;                                   ///< Timestamp of the last animation update
@@ -47,36 +87,133 @@ private:
     RgbColor signalLineColor = RgbColor(0, 100, 0);                 ///< Default color for signal line (green)
     RgbColor displayColor    = RgbColor(100, 0, 0);                 ///< Default color for display (red)
     RgbColor busColor        = RgbColor(0, 0, 100);                 ///< Default color for bus line (blue)
+    RgbColor highlightColor  = RgbColor(0, 255, 0);                 ///< Color of the highlighted PAO row (green)
+    RgbColor errorColor      = RgbColor(255, 0, 0);                 ///< Color of a flashing rejected signal line (red)
+
+    Palette palette;                                                ///< Wire colors referenced by the back buffers
+    RgbColor frontPalette[PALETTE_SIZE];                            ///< Palette snapshot used by the output task (guarded by frameMutex)
 
     const unsigned long BLINK_INTERVAL = 500;                       ///< Interval for blinking animation in milliseconds
     unsigned long lastBlinkTime = 0;                                ///< Timestamp of the last blink state change
     bool blinkState = false;                                        ///< Current blink state (true = on, false = off)
+
+    /**
+     * @struct Flash
+     * @brief Signal line flashing red
+     */
+    struct Flash {
+        SignalLine *line = nullptr;                                 ///< Flashing line, nullptr for a free slot
+        unsigned long startTime = 0;                                ///< Timestamp of the flash start
+    };
+
+    static const uint8_t MAX_FLASHES = 4;                           ///< Most lines flashing at once
+    static const uint8_t FLASH_BLINKS = 3;                          ///< Number of red blinks of a flash
+    const unsigned long FLASH_INTERVAL = 100;                       ///< Time a flashing line stays on or off in milliseconds
+    Flash flashes[MAX_FLASHES];                                     ///< Lines flashing red
+
+    /**
+     * @brief Advance the flashing lines and end the finished flashes
+     * 
+     * A finished line gets its signal color back and is left off.
+     */
+    void updateFlashes();
     long lastRefreshTime = 0;                                       ///< Timestamp of the last display refresh 
+
+    const unsigned long SCROLL_INTERVAL = 300;                      ///< Time a scrolling text stays on one position in milliseconds
+    unsigned long lastScrollTime = 0;                               ///< Timestamp of the last scroll step
+    size_t scrollPosition = 0;                                      ///< Current position of the scrolling text
     
     std::unordered_map<std::string, SignalLine*> signalLineMap;     ///< Map of signal line names to their corresponding SignalLine objects
 
+    FrameStats frameStats;                                          ///< Frame counters and output timing for both strips
+
+    LedElement *elements[LedLayout::ELEMENT_COUNT] = {};             ///< All display elements, in LedLayout::ELEMENTS order
+
     /**
-     * @brief Initialize the right LED strip (RMT Channel 0)
+     * @brief Construct the display element described by a layout entry
+     * 
+     * Picks the element class from entry.kind and places it on the strip selected
+     * by entry.output, using the color of its element type.
+     * 
+     * @param entry Layout table entry describing the element
      * 
-     * Sets up the WS2812B LED strip on the right side with all connected displays
-     * and signal lines. Automatically populates the signalLineMap.
+     * @return Newly allocated element (owned by the DisplayManager)
      * 
-     * @note Called during constructor
-     * @see initStripL()
+     * @note Called for every LedLayout::ELEMENTS entry during constructor
      */
-    void initStripR();
-    
+    LedElement* createElement(const LayoutEntry &entry);
+
     /**
-     * @brief Initialize the left LED strip (RMT Channel 1)
+     * @brief FreeRTOS entry point of the LED output task
      * 
-     * Sets up the WS2812B LED strip on the left side with all connected displays
-     * and signal lines. Automatically populates the signalLineMap.
+     * @param param Pointer to the owning DisplayManager
+     */
+    static void outputTaskEntry(void *param);
+
+    /**
+     * @brief Body of the LED output task
      * 
-     * @note Called during constructor
-     * @see initStripR()
+     * Initializes the RMT channels on the output core, then waits for refreshDisplay()
+     * to publish a frame. Each published front buffer is expanded through the published
+     * palette into its wire buffer, up to the highest changed pixel only. All changed
+     * strips are started on their RMT channel before waiting for any of them, so the
+     * output segments transmit in parallel and a frame takes as long as the longest
+     * prefix that has to be sent. The transmission time and the number of frames merged since the last
+     * pickup are recorded in frameStats.
+     * 
+     * @note Never returns
      */
-    void initStripL();
-    
+    void outputTask();
+
+    /**
+     * @brief Get the element built for a layout entry as its concrete type
+     * 
+     * The entry index and its kind are checked at compile time, so a named pointer
+     * can never be bound to a missing element or an element of another type.
+     * 
+     * @tparam Index Index of the entry in LedLayout::ELEMENTS (use LedLayout::indexOf())
+     * @tparam T Concrete element class matching the entry kind
+     * 
+     * @return Pointer to the element
+     */
+    template<size_t Index, typename T>
+    T* elementAt();
+
+    /**
+     * @brief Get the palette entry used by all elements of a given kind
+     * 
+     * @param kind Element kind from the layout table
+     * 
+     * @return Palette entry for that kind
+     */
+    PaletteIndex getKindColor(const ElementKind kind);
+
+    /**
+     * @brief Get the palette entry of a display element type
+     * 
+     * @param element The DisplayElement type
+     * 
+     * @return Palette entry used by that element type
+     */
+    PaletteIndex getElementPalette(const DisplayElement element);
+
+    /**
+     * @brief Rebuild the palette from the configured element colors
+     * 
+     * Applies the channel swaps of the signal and bus lines and derives the PAO
+     * value/argument colors, so the palette holds ready-to-send wire colors.
+     * The new palette is published with the next refreshDisplay().
+     */
+    void updatePalette();
+
+    /**
+     * @brief Set a PAO color triple (address, value, argument) from one base color
+     * 
+     * @param base Palette entry of the address field; value and argument use base + 1 and base + 2
+     * @param color Base color
+     */
+    void setPaOPalette(PaletteIndex base, const RgbColor &color);
+
     /**
      * @brief Convert a hex color string to an RgbColor object
      * 
@@ -179,9 +316,8 @@ public:
      * @param busColorHEX Hex color string for bus lines (e.g., "#0000FF").
      *                    If nullptr, uses default blue (0, 0, 100).
      * 
-     * @note Constructor automatically calls initStripR() and initStripL()
-     * @see initStripR()
-     * @see initStripL()
+     * @note Constructor builds every element listed in LedLayout::ELEMENTS
+     * @see createElement()
      */
     DisplayManager(const char *signalLineColorHEX = nullptr, 
                    const char *displayColorHEX    = nullptr, 
@@ -190,7 +326,8 @@ public:
     /**
      * @brief Destructor
      * 
-     * Cleans up all dynamically allocated LED strip and display objects.
+     * Stops the LED output task and cleans up all dynamically allocated LED strip,
+     * frame buffer and display objects.
      */
     ~DisplayManager();
 
@@ -206,23 +343,61 @@ public:
     void loadingAnimation();
 
     /**
-     * @brief Turn off all LEDs in both strips
+     * @brief Turn off all LEDs on every output segment
      * 
-     * Disables all LEDs on both the left and right LED strips by setting all
-     * pixels to black (0, 0, 0). Useful for clearing the display between modes.
+     * Disables all display elements on every LED output segment by setting
+     * their pixels to black (0, 0, 0). Useful for clearing the display between modes.
      * 
      * @see refreshDisplay()
      */
     void clearDisplay();
 
     /**
-     * @brief Update the LED strips with current display state
+     * @brief Flash a signal line red to show that its signal was rejected
+     * 
+     * The line blinks FLASH_BLINKS times in PALETTE_ERROR and is then turned off with
+     * its signal color restored. The blinking is driven by refreshDisplay(), so the
+     * caller does not wait. Flashing a line that already flashes starts it again.
+     * 
+     * @param line Line of the rejected signal (ignored if nullptr)
+     * 
+     * @note Only lines of unselected signals should flash; call stopFlash() before
+     *       turning a flashing line on.
+     */
+    void flashSignalLine(SignalLine *line);
+
+    /**
+     * @brief End the flash of a signal line early
      * 
-     * Sends all pending updates to both NeoPixel LED strips. Should be called
-     * regularly to reflect changes in display state on the actual hardware.
+     * Restores the signal color and leaves the line off.
+     * 
+     * @param line Flashing line (nothing happens if it does not flash)
+     */
+    void stopFlash(SignalLine *line);
+
+    /**
+     * @brief Publish the current display state to the LED strips
+     * 
+     * Copies every back buffer that changed since the previous frame into its front
+     * buffer and wakes the LED output task. Strips without changes are skipped. A
+     * changed palette is published as well and republishes every strip, so a color
+     * change shows up on the next frame without redrawing any element.
+     * Should be called regularly to reflect changes in display state on the actual
+     * hardware.
+     * 
+     * @note Does not wait for the transmission; the output task sends the frame
+     *       on its own core.
+     * @see getFrameStats()
      */
     void refreshDisplay();
 
+    /**
+     * @brief Get the frame counters, frame time and output queue depth
+     * 
+     * @return Snapshot of the statistics collected by refreshDisplay() and the output task
+     */
+    FrameStats getFrameStats();
+
     /**
      * @brief Change the color of all display element types
      * 
@@ -236,7 +411,8 @@ public:
      * @param busColorHEX Hex color string for bus lines (e.g., "#0000FF"),
      *                    or nullptr to keep current color.
      * 
-     * @note Changes apply immediately to all corresponding displays
+     * @note Only the palette is updated; every element shows the new color on the next
+     *       refreshDisplay(), including values that are not redrawn.
      * @see setDisplayColor()
      */
     void changeDisplayColor(const char *signalLineColorHEX = nullptr, 
@@ -308,7 +484,7 @@ public:
     /**
      * @brief Run an LED strip test animation
      * 
-     * Cycles through all LEDs on both strips.
+     * Cycles through all LEDs on every output segment.
      * Useful for verifying LED functionality and identifying faulty segments.
      * 
      * @param updateSpeedMillis Time in milliseconds between color changes
@@ -321,9 +497,9 @@ public:
     void ledTestAnimation(int updateSpeedMillis, bool printInSerial = false, bool reset = false);
     
     /**
-     * @brief Set all LEDs on both strips to a specific color
+     * @brief Set all LEDs on every output segment to a specific color
      * 
-     * Lights up all LEDs on both the left and right strips with the same RGB color.
+     * Lights up all LEDs on every output segment with the same RGB color.
      * Useful for status indication or uniform display mode.
      * 
      * @param red Red channel intensity (0-255). Default: 50
@@ -336,4 +512,20 @@ public:
     void controlAllLEDs(int red = 50, int green = 0, int blue = 0);
 
     void showIP(IPAddress ip);
+
+    /**
+     * @brief Scroll a text message across a PAO row
+     * 
+     * The text enters from the right and moves one digit to the left every
+     * SCROLL_INTERVAL milliseconds, then starts over once it has left the row.
+     * Rendering goes through the SegmentFont table and does not allocate.
+     * 
+     * @param text Null-terminated message
+     * @param row PAO row to scroll on (0-3). Default: 0
+     * @param reset If true, restarts the message from the right edge
+     * 
+     * @note Call every loop iteration while the message should be shown
+     * @see PaODisplayLine::displayText()
+     */
+    void scrollText(const char *text, int row = 0, bool reset = false);
 };
\ No newline at end of file
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "palette.h"
+
+/**
+ * @file frame_buffer.h
+ * @brief Back buffer holding the pixels of one LED strip as palette indices
+ *
+ * Display elements never write to the NeoPixelBus strips directly. They write into a
+ * FrameBuffer, which is owned by the DisplayManager and only read by the LED output task
+ * when a frame is published. Every pixel is one PaletteIndex byte; expand() turns it
+ * into the wire order of NeoGrbFeature (G, R, B) only when the frame is sent.
+ *
+ * Writes that do not change a pixel are skipped, and the buffer remembers the highest
+ * pixel that changed since the last frame. WS2812 chains latch from the first pixel, so
+ * the output task only has to send that prefix of the strip.
+ *
+ * Elements write through span operations (fill(), writeMask()) that clip the range
+ * once and then run a branch-free inner loop. The buffer has no hardware dependency,
+ * so elements can also render into it on the host.
+ *
+ * @author Bartosz Faruga / MrRooby
+ * @date 2025
+ */
+class FrameBuffer {
+    private:
+        uint8_t *data = nullptr;                ///< One PaletteIndex per pixel
+        uint16_t pixelCount = 0;                ///< Number of pixels in the buffer
+        uint16_t dirtyEnd = 0;                  ///< One past the highest pixel changed since the last resetDirty() (0 = clean)
+
+        /** @brief Extend the dirty prefix to cover pixels up to end - 1 */
+        void markDirtyUpTo(uint16_t end);
+
+        /** @brief Number of pixels of a span that lie inside the buffer */
+        uint16_t clipCount(uint16_t start, uint16_t count) const;
+
+    public:
+        static const size_t BYTES_PER_PIXEL = 3;   ///< Bytes per pixel on the wire (NeoGrbFeature)
+
+        /**
+         * @brief Construct a frame buffer with all pixels off
+         *
+         * @param pixelCount Number of pixels of the strip
+         *
+         * @note A new buffer starts fully dirty so its first frame is always sent.
+         */
+        FrameBuffer(uint16_t pixelCount);
+
+        /**
+         * @brief Destructor
+         *
+         * Frees the pixel data.
+         */
+        ~FrameBuffer();
+
+        FrameBuffer(const FrameBuffer&) = delete;
+        FrameBuffer& operator=(const FrameBuffer&) = delete;
+
+        /**
+         * @brief Set the palette entry of a single pixel
+         *
+         * Only writes (and marks the buffer dirty) when the entry differs from the
+         * stored one. Indexes outside the buffer are ignored.
+         *
+         * @param index Pixel index within the strip
+         * @param color New palette entry of the pixel
+         */
+        void setPixel(uint16_t index, PaletteIndex color);
+
+        /**
+         * @brief Get the palette entry of a single pixel
+         *
+         * @param index Pixel index within the strip
+         *
+         * @return Stored entry, or PALETTE_OFF for indexes outside the buffer
+         */
+        PaletteIndex getPixel(uint16_t index) const;
+
+        /**
+         * @brief Set every pixel of the buffer to the same palette entry
+         *
+         * @param color Palette entry to fill the buffer with
+         */
+        void fill(PaletteIndex color);
+
+        /**
+         * @brief Set a range of pixels to the same palette entry
+         *
+         * The range is clipped to the buffer once, before the loop.
+         *
+         * @param start Index of the first pixel
+         * @param count Number of pixels to fill
+         * @param color Palette entry to fill the range with
+         */
+        void fill(uint16_t start, uint16_t count, PaletteIndex color);
+
+        /**
+         * @brief Write a range of pixels from a bit mask
+         *
+         * Pixel start + n gets onColor when bit n of the mask is set and offColor
+         * otherwise. Used to render a whole 7-segment digit in one call.
+         *
+         * @param start Index of the first pixel
+         * @param count Number of pixels to write (at most 32)
+         * @param mask Bit n selects the color of pixel start + n
+         * @param onColor Palette entry of pixels whose bit is set
+         * @param offColor Palette entry of pixels whose bit is clear
+         */
+        void writeMask(uint16_t start, uint16_t count, uint32_t mask, PaletteIndex onColor, PaletteIndex offColor);
+
+        /**
+         * @brief Copy every pixel of another buffer of the same size
+         *
+         * Used to publish a finished back buffer into the front buffer read by the
+         * LED output task. The dirty prefix of the source is added to the dirty prefix
+         * of this buffer, so frames merged before the output task picks them up still
+         * send every changed pixel.
+         *
+         * @param source Buffer to copy from. Must have the same pixel count.
+         */
+        void copyFrom(const FrameBuffer &source);
+
+        /**
+         * @brief Expand the first pixels of the buffer into G, R, B wire data
+         *
+         * @param grb Destination with room for count * BYTES_PER_PIXEL bytes
+         * @param palette Wire colors, indexed by PaletteIndex
+         * @param count Number of pixels to expand (clipped to the buffer)
+         */
+        void expand(uint8_t *grb, const RgbColor *palette, uint16_t count) const;
+
+        /** @brief Check whether any pixel changed since the last resetDirty() */
+        bool isDirty() const;
+
+        /**
+         * @brief Number of leading pixels that have to be sent to show every change
+         *
+         * @return One past the highest changed pixel, or 0 when nothing changed
+         */
+        uint16_t getDirtyEnd() const;
+
+        /** @brief Force the next refresh to publish the whole buffer */
+        void markDirty();
+
+        /**
+         * @brief Clear the dirty prefix
+         *
+         * Back buffers are reset by refreshDisplay() right after they were published,
+         * front buffers by the output task while holding the frame mutex, so the
+         * prefix is never touched by two tasks at once.
+         */
+        void resetDirty();
+
+        /** @brief Number of pixels in the buffer */
+        uint16_t getPixelCount() const;
+};
@@ -2,7 +2,7 @@
 
 #include <Arduino.h>
 #include "pins.h"
-#include <map>
+#include "w_signals.h"
 
 /**
  * @file human_interface.h
@@ -39,6 +39,18 @@ enum EncoderState {
     DOWN = 2,
 };
 
+/**
+ * @struct PanelButton
+ * @brief One physical button of the panel
+ */
+struct PanelButton {
+    const char *name;   ///< Button label (signal name or "TAKT")
+    Signal signal;      ///< Signal selected by the button, Signal::NONE for TAKT
+
+    /** @brief Check whether this is the TAKT button */
+    bool isTakt() const { return signal == Signal::NONE; }
+};
+
 /**
  * @class HumanInterface
  * @brief Central input/output interface for user controls
@@ -71,30 +83,28 @@ private:
 
     const int ONBOARD_LED_BRIGHTNESS = 64;                  ///< PWM brightness level for on-board LEDs (0-255)
     
-    /// @brief Button name mapping from multiplexer channel to signal names
-    /// Maps channels 0-15 (multiplexer) and 16 (WYS special button) to signal command names
-    const std::map<int, char*> buttons = {
-        { 1,  "PRZEP" },
-        { 2,  "ODE" },
-        { 3,  "WYAD" },
-        { 4,  "DOD" },
-        { 5,  "WYL" },
-        { 6,  "WEL" },
-        { 7,  "WEAK" },
-        { 8,  "WEA" },
-        { 10, "PISZ" },
-        { 11, "CZYT" },
-        { 12, "WES" },
-        { 13, "IL" },
-        { 14, "WYAK" },
-        { 15, "WYS" },
-        
-        
-        
-        { 16, "WEI" },
-        { 0,  "WEJA" },
-        { 9,  "TAKT" },
-        
+    static const int BUTTON_COUNT = 17;                     ///< Multiplexer channels 0-15 and the special button (16)
+
+    /// @brief Button table indexed by multiplexer channel
+    /// Maps channels 0-15 (multiplexer) and 16 (WYS special button) to signal commands
+    static constexpr PanelButton BUTTONS[BUTTON_COUNT] = {
+        { "WEJA",  Signal::WEJA  },     // 0
+        { "PRZEP", Signal::PRZEP },     // 1
+        { "ODE",   Signal::ODE   },     // 2
+        { "WYAD",  Signal::WYAD  },     // 3
+        { "DOD",   Signal::DOD   },     // 4
+        { "WYL",   Signal::WYL   },     // 5
+        { "WEL",   Signal::WEL   },     // 6
+        { "WEAK",  Signal::WEAK  },     // 7
+        { "WEA",   Signal::WEA   },     // 8
+        { "TAKT",  Signal::NONE  },     // 9
+        { "PISZ",  Signal::PISZ  },     // 10
+        { "CZYT",  Signal::CZYT  },     // 11
+        { "WES",   Signal::WES   },     // 12
+        { "IL",    Signal::IL    },     // 13
+        { "WYAK",  Signal::WYAK  },     // 14
+        { "WYS",   Signal::WYS   },     // 15
+        { "WEI",   Signal::WEI   },     // 16
     };
 
     /*
@@ -161,21 +171,22 @@ public:
     /**
      * @brief Get the currently pressed button
      * 
-     * Scans the button matrix via multiplexer and returns the name of the first
+     * Scans the button matrix via multiplexer and returns the first
      * pressed button found. Implements debouncing to filter out noise.
      * 
      * **Scanning priority:**
      * @li Checks special WYS button first (highest priority)
      * @li Then scans multiplexer channels 0-15 in order
      * 
-     * @return Pointer to the button name string (e.g., "IL", "WEL", "WYS"),
-     *         or nullptr if no button is pressed
+     * @return Pointer to the entry of BUTTONS (name and Signal, e.g. "IL"),
+     *         or nullptr if no button is pressed. The pointer stays the same while
+     *         the button is held, so callers can detect presses by comparing it.
      * 
      * @note Returns only the first pressed button; if multiple buttons are pressed,
      *       only the first one in scan order is reported
-     * @see buttons
+     * @see BUTTONS
      */
-    char* getPressedButton();
+    const PanelButton* getPressedButton();
 
     /**
      * @brief Check if WiFi mode switch is enabled
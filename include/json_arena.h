@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <ArduinoJson.h>
+
+/**
+ * @file json_arena.h
+ * @brief Fixed-size ArduinoJson allocator for the WebSocket handlers
+ *
+ * ArduinoJson 7 documents allocate their memory pools from the heap. A document
+ * constructed with a JsonArena takes them from a buffer that lives with its owner
+ * instead: allocation is a pointer bump, freeing is a no-op, and reset() recycles the
+ * whole buffer once the document is gone. A message that needs more than SIZE bytes
+ * fails to deserialize with DeserializationError::NoMemory instead of growing the heap.
+ *
+ * @author Bartosz Faruga / MrRooby
+ * @date 2025
+ */
+
+template <size_t SIZE>
+class JsonArena : public ArduinoJson::Allocator
+{
+private:
+    static constexpr size_t ALIGN = 8;                       ///< Alignment of every block
+
+    /// Size stored in front of every block, for reallocate()
+    struct alignas(ALIGN) Header {
+        size_t size;
+    };
+
+    alignas(ALIGN) uint8_t buffer[SIZE];                     ///< Memory handed out to the document
+    size_t used = 0;                                         ///< Bytes of buffer in use
+
+    static constexpr size_t roundUp(size_t size) { return (size + ALIGN - 1) & ~(ALIGN - 1); }
+
+public:
+    void* allocate(size_t size) override
+    {
+        size_t needed = sizeof(Header) + roundUp(size);
+        if(this->used + needed > SIZE){
+            return nullptr;
+        }
+
+        Header *header = reinterpret_cast<Header*>(this->buffer + this->used);
+        header->size = size;
+        this->used += needed;
+        return header + 1;
+    }
+
+    void deallocate(void *) override {}
+
+    void* reallocate(void *pointer, size_t size) override
+    {
+        if(!pointer){
+            return this->allocate(size);
+        }
+
+        Header *header = reinterpret_cast<Header*>(pointer) - 1;
+        uint8_t *end = reinterpret_cast<uint8_t*>(pointer) + roundUp(header->size);
+
+        // The last block grows or shrinks in place
+        if(end == this->buffer + this->used){
+            size_t start = reinterpret_cast<uint8_t*>(pointer) - this->buffer;
+            if(start + roundUp(size) > SIZE){
+                return nullptr;
+            }
+            this->used = start + roundUp(size);
+            header->size = size;
+            return pointer;
+        }
+
+        void *moved = this->allocate(size);
+        if(moved){
+            memcpy(moved, pointer, (header->size < size) ? header->size : size);
+        }
+        return moved;
+    }
+
+    /** @brief Recycle the whole buffer; every document using it must be destroyed */
+    void reset() { this->used = 0; }
+};
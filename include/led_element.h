@@ -1,26 +1,80 @@
 #pragma once
 
-#include <NeoPixelBus.h>
+#include "frame_buffer.h"
 
 /**
  * @file led_element.h
  * @brief Base class for LED elements controlled via NeoPixelBus
  * 
  * Provides foundational functionality for controlling individual LED elements
- * within NeoPixel (WS2812B) LED strips. Supports dual RMT channels for independent
- * strip control and includes color management with channel swapping capabilities.
+ * within NeoPixel (WS2812B) LED strips. Elements write into the FrameBuffer of the
+ * strip they are wired to. Colors are PaletteIndex entries, so the actual RGB value
+ * (including any channel swap of the LEDs) is owned by the DisplayManager palette.
+ * 
+ * All pixel writes go through whole-element span operations (fillPixels(), writeMask()),
+ * so no element loops over its pixels itself.
+ * 
+ * Elements are retained: each one remembers the state (e.g. the segment mask or the
+ * on/off state of a line) and the color it last drew. Drawing the same state in the same
+ * color again is a no-op, and setColor() redraws the remembered state in the new color,
+ * so callers only have to push values when the machine state really changed.
  * 
  * @author Bartosz Faruga / MrRooby
  * @date 2025
  */
 class LedElement {
     protected:
-        NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt0Ws2812xMethod>* strip0 = nullptr;
-        NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt1Ws2812xMethod>* strip1 = nullptr;
+        FrameBuffer *frame = nullptr;   ///< Back buffer of the strip this element is wired to
+
+        uint16_t startIndex = 0;
+        uint16_t pixelCount = 0;
+        PaletteIndex color = PALETTE_OFF;
 
-        int startIndex;
-        int pixelCount = 0;
-        RgbColor color;
+        static const uint32_t NOT_RENDERED = 0xFFFFFFFF;   ///< renderedState of an element whose pixels are unknown
+
+        uint32_t renderedState = NOT_RENDERED;  ///< State drawn by the last render() call
+        PaletteIndex renderedColor = PALETTE_OFF; ///< Color used by the last render() call
+
+        /**
+         * @brief Draw a state unless it is already shown in the current color
+         * 
+         * @param state Element specific state passed to render()
+         */
+        void renderState(uint32_t state);
+
+        /**
+         * @brief Draw a state with the current color
+         * 
+         * Only called by renderState(). The default does nothing; elements that are
+         * made of sub-elements leave the drawing to them.
+         * 
+         * @param state Element specific state (segment mask, line on/off, ...)
+         */
+        virtual void render(uint32_t state);
+
+        /**
+         * @brief Set every pixel of this element to one color
+         * 
+         * Writes into the strip's FrameBuffer, which only stores the color (and marks
+         * the strip as dirty) when it differs from the current one. This lets
+         * DisplayManager::refreshDisplay() skip strips that did not change.
+         * 
+         * @param color The palette entry to write
+         * 
+         * @see DisplayManager::refreshDisplay()
+         */
+        void fillPixels(PaletteIndex color);
+
+        /**
+         * @brief Light the pixels of this element selected by a bit mask
+         * 
+         * Pixel n of the element is set to color when bit n of the mask is set and
+         * turned off otherwise. Unchanged pixels are skipped like in fillPixels().
+         * 
+         * @param mask Bit n selects pixel n (at most 32 pixels)
+         * @param color The palette entry of the selected pixels
+         */
+        void writeMask(uint32_t mask, PaletteIndex color);
 
     public:
         /**
@@ -30,92 +84,59 @@ class LedElement {
          * Must be configured via parametrized constructors before use.
          */
         LedElement() = default;
-        
+
         /**
-         * @brief Construct a new Led Element for Channel 0 (RMT0)
-         * 
-         * Initializes an LED element that controls a segment of an LED strip using
-         * the NeoEsp32Rmt0Ws2812xMethod (RMT channel 0).
+         * @brief Virtual destructor
          * 
-         * @param strip0 Pointer to the NeoPixelBus object representing the LED strip (channel 0).
-         *               Must not be nullptr.
-         * @param startIndex The starting index (pixel position) of this LED element within the strip.
-         *                   Should be >= 0 and < total number of pixels.
-         * @param color The initial RgbColor value to assign to this element.
-         *              Can be changed later with setColor().
-         * 
-         * @note The pixel count is not set in this constructor; derived classes should set
-         *       pixelCount as needed.
-         * @see setColor()
+         * Elements are owned and deleted through LedElement pointers by the DisplayManager.
          */
-        LedElement(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt0Ws2812xMethod>* strip0, int startIndex, RgbColor color);
+        virtual ~LedElement() = default;
         
         /**
-         * @brief Construct a new Led Element for Channel 1 (RMT1)
+         * @brief Construct a new Led Element
          * 
-         * Initializes an LED element that controls a segment of an LED strip using
-         * the NeoEsp32Rmt1Ws2812xMethod (RMT channel 1).
+         * Initializes an LED element that controls a segment of an LED strip through
+         * the strip's FrameBuffer.
          * 
-         * @param strip1 Pointer to the NeoPixelBus object representing the LED strip (channel 1).
-         *               Must not be nullptr.
+         * @param frame Pointer to the FrameBuffer of the LED strip.
+         *              Must not be nullptr.
          * @param startIndex The starting index (pixel position) of this LED element within the strip.
          *                   Should be >= 0 and < total number of pixels.
-         * @param color The initial RgbColor value to assign to this element.
+         * @param color The initial palette entry of this element.
          *              Can be changed later with setColor().
          * 
          * @note The pixel count is not set in this constructor; derived classes should set
          *       pixelCount as needed.
          * @see setColor()
          */
-        LedElement(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt1Ws2812xMethod>* strip1, int startIndex, RgbColor color);
+        LedElement(FrameBuffer *frame, int startIndex, PaletteIndex color);
         
         /**
          * @brief Set the color of the LED element
          * 
-         * Updates the color of this LED element. If the R and G channels are swapped
-         * (indicated by the swappedRG flag), the color will be automatically adjusted
-         * before being stored.
-         * 
-         * **Color adjustment:**
-         * @li If swappedRG is true: (R, G, B) → (G, R, B)
-         * @li If swappedRG is false: color is stored as-is
+         * Selects the palette entry of this element and redraws the retained state
+         * in the new color.
          * 
-         * @param color The new RgbColor to set for this element
+         * @param color The new palette entry for this element
          * 
-         * @note This is a virtual method; derived classes can override to add custom behavior
-         *       such as immediately updating the LED strip.
-         * @see swapRG()
+         * @note This is a virtual method; derived classes can override it to forward
+         *       the color to their sub-elements.
          */
-        virtual void setColor(RgbColor color);
+        virtual void setColor(PaletteIndex color);
 
         /**
-         * @brief Swaps the Red and Green channels of an RGB color
-         * 
-         * Useful for correcting color channel ordering mismatches between different
-         * LED strips or configurations. Converts (R, G, B) to (G, R, B).
-         * 
-         * **Example:**
-         * @li Input: RgbColor(255, 128, 0) (red-ish orange)
-         * @li Output: RgbColor(128, 255, 0) (green-ish yellow)
+         * @brief Turn off every pixel of this element
          * 
-         * @param color The original RgbColor to swap channels for
+         * Sets all pixelCount pixels starting at startIndex to PALETTE_OFF.
          * 
-         * @return A new RgbColor with R and G channels swapped, B channel unchanged
-         * 
-         * @note This is a utility function and does not modify the element's internal color.
-         *       Use setColor() to apply a swapped color to the element.
+         * @see DisplayManager::clearDisplay()
          */
-        RgbColor swapRG(const RgbColor &color);
-        
+        void clear();
+
         /**
-         * @brief Swaps the Red and Blue channels of an RGB color
-         * 
-         * @param color The original RgbColor to swap channels for
-         * 
-         * @return A new RgbColor with R and B channels swapped, G channel unchanged
+         * @brief Forget the retained state so the next draw always writes its pixels
          * 
-         * @note This is a utility function and does not modify the element's internal color.
-         *       Use setColor() to apply a swapped color to the element.
+         * Used after the pixels of the element were overwritten behind its back.
          */
-        RgbColor swapRB(const RgbColor &color);
+        virtual void invalidate();
 };
\ No newline at end of file
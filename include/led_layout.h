@@ -0,0 +1,254 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "pins.h"
+
+/**
+ * @file led_layout.h
+ * @brief Declarative table of every display element on both LED strips
+ *
+ * The whole panel is described by one constexpr table (LedLayout::ELEMENTS). The
+ * DisplayManager builds its elements from it, and the strip lengths (LED_COUNT_R,
+ * LED_COUNT_L) are derived from it, so the NeoPixelBus buffers and the WS2812 frame
+ * only cover pixels that are actually wired to an element.
+ *
+ * Every element is placed on one of the output segments listed in LedLayout::OUTPUTS.
+ * Each output segment is a separate WS2812 chain with its own data pin and RMT TX
+ * channel, and all segments transmit at the same time, so a frame takes as long as
+ * the longest segment. Splitting the panel into more segments (up to the four RMT TX
+ * channels of the ESP32-S3) only needs a new OUTPUTS entry and new element offsets.
+ *
+ * The table is checked at compile time:
+ * @li elements placed on the same output must not share pixels
+ * @li fixed-size elements (digit displays, PaO lines) must declare their real length
+ * @li element names must be unique
+ * @li every element must use an existing output, and no two outputs may share an RMT channel or pin
+ *
+ * @author Bartosz Faruga / MrRooby
+ * @date 2025
+ */
+
+/**
+ * @enum ElementKind
+ * @brief Type of display element created for a layout entry
+ */
+enum class ElementKind : uint8_t {
+    THREE_DIGIT,    ///< ThreeDigitDisplay (register value)
+    PAO_LINE,       ///< PaODisplayLine (memory row)
+    SIGNAL,         ///< SignalLine (control signal)
+    BUS             ///< BusLine (data bus)
+};
+
+/**
+ * @struct LedOutput
+ * @brief One WS2812 output segment (data pin and RMT TX channel)
+ */
+struct LedOutput {
+    const char *name;   ///< Human readable segment name (used in debug output)
+    uint8_t pin;        ///< GPIO pin of the data line
+    uint8_t channel;    ///< RMT TX channel driving the pin
+};
+
+/**
+ * @struct LayoutEntry
+ * @brief Placement of one display element on an LED strip
+ */
+struct LayoutEntry {
+    ElementKind kind;   ///< Element type to construct
+    const char *name;   ///< Unique element name (also used as the signal line name)
+    uint8_t output;     ///< Index of the output segment in LedLayout::OUTPUTS
+    uint16_t offset;    ///< Index of the first pixel of the element
+    uint16_t length;    ///< Number of pixels used by the element
+
+    /** @brief Index one past the last pixel of the element */
+    constexpr uint16_t end() const { return offset + length; }
+};
+
+namespace LedLayout {
+    constexpr uint16_t SEGMENT_LEDS     = 7;                                    ///< Pixels in one 7-segment digit
+    constexpr uint16_t TWO_DIGIT_LEDS   = 2 * SEGMENT_LEDS;                     ///< Pixels in a TwoDigitDisplay
+    constexpr uint16_t THREE_DIGIT_LEDS = 3 * SEGMENT_LEDS;                     ///< Pixels in a ThreeDigitDisplay
+    constexpr uint16_t PAO_LINE_LEDS    = 2 * TWO_DIGIT_LEDS + THREE_DIGIT_LEDS; ///< Pixels in a PaODisplayLine
+    constexpr uint16_t BUS_LEDS         = 78;                                   ///< Pixels in a BusLine
+
+    constexpr uint8_t RMT_TX_CHANNELS = 4;  ///< RMT TX channels available on the ESP32-S3
+
+    constexpr uint8_t OUT_R = 0;            ///< Index of the right strip in OUTPUTS
+    constexpr uint8_t OUT_L = 1;            ///< Index of the left strip in OUTPUTS
+
+    constexpr LedOutput OUTPUTS[] = {
+        {"RIGHT", LED_PORT_R, 0},
+        {"LEFT",  LED_PORT_L, 1},
+    };
+
+    constexpr size_t OUTPUT_COUNT = sizeof(OUTPUTS) / sizeof(OUTPUTS[0]);     ///< Number of output segments
+
+    constexpr LayoutEntry ELEMENTS[] = {
+        // ============================ Right strip ============================
+        {ElementKind::SIGNAL,      "wyak",  OUT_R, 0,   34},
+        {ElementKind::THREE_DIGIT, "acc",   OUT_R, 34,  THREE_DIGIT_LEDS},
+        {ElementKind::SIGNAL,      "wea",   OUT_R, 55,  3},
+        {ElementKind::THREE_DIGIT, "a",     OUT_R, 58,  THREE_DIGIT_LEDS},
+        {ElementKind::PAO_LINE,    "pao0",  OUT_R, 79,  PAO_LINE_LEDS},
+        {ElementKind::PAO_LINE,    "pao1",  OUT_R, 128, PAO_LINE_LEDS},
+        {ElementKind::SIGNAL,      "pisz",  OUT_R, 177, 3},
+        {ElementKind::SIGNAL,      "czyt",  OUT_R, 180, 3},
+        {ElementKind::PAO_LINE,    "pao2",  OUT_R, 184, PAO_LINE_LEDS},
+        {ElementKind::PAO_LINE,    "pao3",  OUT_R, 233, PAO_LINE_LEDS},
+        {ElementKind::THREE_DIGIT, "s",     OUT_R, 282, THREE_DIGIT_LEDS},
+        {ElementKind::SIGNAL,      "wes",   OUT_R, 303, 9},
+        {ElementKind::SIGNAL,      "wys",   OUT_R, 312, 9},
+        {ElementKind::BUS,         "busS",  OUT_R, 321, BUS_LEDS},
+
+        // ============================ Left strip =============================
+        {ElementKind::SIGNAL,      "weja",  OUT_L, 0,   4},
+        {ElementKind::SIGNAL,      "wei",   OUT_L, 4,   4},
+        {ElementKind::THREE_DIGIT, "i",     OUT_L, 8,   THREE_DIGIT_LEDS},
+        {ElementKind::SIGNAL,      "przep", OUT_L, 29,  3},
+        {ElementKind::SIGNAL,      "ode",   OUT_L, 33,  3},
+        {ElementKind::SIGNAL,      "dod",   OUT_L, 36,  3},
+        {ElementKind::SIGNAL,      "weak",  OUT_L, 39,  3},
+        {ElementKind::SIGNAL,      "wyad1", OUT_L, 42,  8},
+        {ElementKind::SIGNAL,      "stop",  OUT_L, 50,  15},
+        {ElementKind::SIGNAL,      "wyad2", OUT_L, 65,  36},
+        {ElementKind::SIGNAL,      "wel",   OUT_L, 101, 3},
+        {ElementKind::SIGNAL,      "wyl",   OUT_L, 104, 3},
+        {ElementKind::SIGNAL,      "il",    OUT_L, 107, 3},
+        {ElementKind::THREE_DIGIT, "c",     OUT_L, 110, THREE_DIGIT_LEDS},
+        {ElementKind::BUS,         "busA",  OUT_L, 131, BUS_LEDS},
+    };
+
+    constexpr size_t ELEMENT_COUNT = sizeof(ELEMENTS) / sizeof(ELEMENTS[0]);  ///< Number of elements on the panel
+
+    /** @brief Compile-time string comparison used for element name lookup */
+    constexpr bool namesEqual(const char *a, const char *b)
+    {
+        while (*a && *a == *b) {
+            a++;
+            b++;
+        }
+        return *a == *b;
+    }
+
+    /**
+     * @brief Find a layout entry by name
+     *
+     * @param name Element name from the ELEMENTS table
+     *
+     * @return Index of the entry in ELEMENTS, or ELEMENT_COUNT if not found
+     */
+    constexpr size_t indexOf(const char *name)
+    {
+        for (size_t i = 0; i < ELEMENT_COUNT; i++) {
+            if (namesEqual(ELEMENTS[i].name, name)) {
+                return i;
+            }
+        }
+        return ELEMENT_COUNT;
+    }
+
+    /**
+     * @brief Number of pixels needed to drive every element of an output segment
+     *
+     * @param output Index of the output segment in OUTPUTS
+     *
+     * @return Index one past the last pixel used by any element on the segment
+     */
+    constexpr uint16_t stripLength(uint8_t output)
+    {
+        uint16_t length = 0;
+        for (size_t i = 0; i < ELEMENT_COUNT; i++) {
+            if (ELEMENTS[i].output == output && ELEMENTS[i].end() > length) {
+                length = ELEMENTS[i].end();
+            }
+        }
+        return length;
+    }
+
+    /** @brief Check that no two elements on the same output share a pixel */
+    constexpr bool hasNoOverlaps()
+    {
+        for (size_t i = 0; i < ELEMENT_COUNT; i++) {
+            for (size_t j = i + 1; j < ELEMENT_COUNT; j++) {
+                if (ELEMENTS[i].output == ELEMENTS[j].output &&
+                    ELEMENTS[i].offset < ELEMENTS[j].end() &&
+                    ELEMENTS[j].offset < ELEMENTS[i].end()) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /** @brief Check that fixed-size elements declare their real pixel count */
+    constexpr bool hasValidLengths()
+    {
+        for (size_t i = 0; i < ELEMENT_COUNT; i++) {
+            const LayoutEntry &entry = ELEMENTS[i];
+            if (entry.length == 0) {
+                return false;
+            }
+            if (entry.kind == ElementKind::THREE_DIGIT && entry.length != THREE_DIGIT_LEDS) {
+                return false;
+            }
+            if (entry.kind == ElementKind::PAO_LINE && entry.length != PAO_LINE_LEDS) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** @brief Check that every element name is used only once */
+    constexpr bool hasUniqueNames()
+    {
+        for (size_t i = 0; i < ELEMENT_COUNT; i++) {
+            if (indexOf(ELEMENTS[i].name) != i) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** @brief Check that every element uses an output that exists and every output drives pixels */
+    constexpr bool hasValidOutputs()
+    {
+        for (size_t i = 0; i < ELEMENT_COUNT; i++) {
+            if (ELEMENTS[i].output >= OUTPUT_COUNT) {
+                return false;
+            }
+        }
+        for (size_t n = 0; n < OUTPUT_COUNT; n++) {
+            if (stripLength(n) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** @brief Check that outputs use distinct, existing RMT channels and distinct pins */
+    constexpr bool hasValidChannels()
+    {
+        for (size_t i = 0; i < OUTPUT_COUNT; i++) {
+            if (OUTPUTS[i].channel >= RMT_TX_CHANNELS) {
+                return false;
+            }
+            for (size_t j = i + 1; j < OUTPUT_COUNT; j++) {
+                if (OUTPUTS[i].channel == OUTPUTS[j].channel || OUTPUTS[i].pin == OUTPUTS[j].pin) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static_assert(OUTPUT_COUNT <= RMT_TX_CHANNELS, "LED layout: more outputs than RMT TX channels");
+    static_assert(hasValidOutputs(),  "LED layout: element placed on a missing or empty output");
+    static_assert(hasValidChannels(), "LED layout: outputs must use distinct RMT channels and pins");
+    static_assert(hasNoOverlaps(),   "LED layout: two elements on the same output share pixels");
+    static_assert(hasValidLengths(), "LED layout: element length does not match its kind");
+    static_assert(hasUniqueNames(),  "LED layout: element names must be unique");
+}
+
+constexpr uint16_t LED_COUNT_R = LedLayout::stripLength(LedLayout::OUT_R);  ///< LED count of the right LED strip
+constexpr uint16_t LED_COUNT_L = LedLayout::stripLength(LedLayout::OUT_L);  ///< LED count of the left LED strip
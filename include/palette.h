@@ -0,0 +1,125 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef ARDUINO
+#include <NeoPixelBus.h>
+#else
+/**
+ * @brief Host stand-in for the NeoPixelBus RgbColor
+ *
+ * Lets the palette, the frame buffer and the display elements build and run on a PC
+ * (e.g. helpers/ experiments) without the NeoPixelBus library.
+ */
+struct RgbColor {
+    uint8_t R = 0;
+    uint8_t G = 0;
+    uint8_t B = 0;
+
+    RgbColor() = default;
+    RgbColor(uint8_t r, uint8_t g, uint8_t b) : R(r), G(g), B(b) {}
+
+    bool operator==(const RgbColor &other) const { return R == other.R && G == other.G && B == other.B; }
+    bool operator!=(const RgbColor &other) const { return !(*this == other); }
+};
+#endif
+
+/**
+ * @file palette.h
+ * @brief Shared color palette referenced by every pixel of the frame buffers
+ *
+ * Pixels do not store colors. They store an index into this palette, and the colors
+ * are only expanded to the G, R, B wire format when a frame is sent. Changing the
+ * color of a whole element type is therefore a single palette write that shows up
+ * on the next frame, without redrawing any element.
+ *
+ * Entries hold the color as it has to be sent on the wire, so per-element channel
+ * swaps (signal and bus lines, PAO value/argument fields) are applied once when the
+ * palette is built instead of in every element.
+ *
+ * @author Bartosz Faruga / MrRooby
+ * @date 2025
+ */
+
+/**
+ * @enum PaletteIndex
+ * @brief Palette entry stored in each pixel
+ *
+ * @note Each *_ALT and *_ALT_ARG entry must directly follow its base entry;
+ *       PaODisplayLine picks its value and argument colors as base + 1 and base + 2.
+ */
+enum PaletteIndex : uint8_t {
+    PALETTE_OFF = 0,            ///< Pixel turned off (always black)
+    PALETTE_SIGNAL,             ///< Signal lines
+    PALETTE_BUS,                ///< Bus lines
+    PALETTE_DISPLAY,            ///< Digit displays and the PAO address field
+    PALETTE_DISPLAY_ALT,        ///< PAO value field
+    PALETTE_DISPLAY_ALT_ARG,    ///< PAO argument field
+    PALETTE_HIGHLIGHT,          ///< Address field of the highlighted PAO row
+    PALETTE_HIGHLIGHT_ALT,      ///< Value field of the highlighted PAO row
+    PALETTE_HIGHLIGHT_ALT_ARG,  ///< Argument field of the highlighted PAO row
+    PALETTE_ERROR,              ///< Flashing line of a rejected signal
+    PALETTE_TEST,               ///< Free color used by the LED test modes
+    PALETTE_SIZE                ///< Number of palette entries
+};
+
+/**
+ * @class Palette
+ * @brief Table of wire colors indexed by PaletteIndex
+ */
+class Palette {
+    private:
+        RgbColor colors[PALETTE_SIZE];      ///< Wire color of every entry
+        bool changed = true;                ///< Set when an entry changed since the last clearChanged()
+
+    public:
+        /**
+         * @brief Construct a palette with every entry black
+         *
+         * The NeoPixelBus RgbColor leaves its channels undefined, so the entries are
+         * cleared here; PALETTE_OFF is never written afterwards.
+         */
+        Palette();
+
+        /**
+         * @brief Set the color of a palette entry
+         *
+         * @param index Entry to change. PALETTE_OFF always stays black.
+         * @param color New wire color of the entry
+         */
+        void set(PaletteIndex index, const RgbColor &color);
+
+        /** @brief Get the color of a palette entry */
+        const RgbColor& get(PaletteIndex index) const;
+
+        /** @brief All entries, in PaletteIndex order */
+        const RgbColor* data() const;
+
+        /** @brief Check whether any entry changed since the last clearChanged() */
+        bool hasChanged() const;
+
+        /** @brief Clear the changed flag after the palette was published */
+        void clearChanged();
+
+        /**
+         * @brief Swaps the Red and Green channels of an RGB color
+         *
+         * Converts (R, G, B) to (G, R, B). Used for LEDs wired with a different
+         * channel order than the rest of the strip.
+         *
+         * @param color The original RgbColor
+         *
+         * @return A new RgbColor with R and G channels swapped, B channel unchanged
+         */
+        static RgbColor swapRG(const RgbColor &color);
+
+        /**
+         * @brief Swaps the Red and Blue channels of an RGB color
+         *
+         * @param color The original RgbColor
+         *
+         * @return A new RgbColor with R and B channels swapped, G channel unchanged
+         */
+        static RgbColor swapRB(const RgbColor &color);
+};
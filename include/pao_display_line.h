@@ -20,9 +20,15 @@
  * @author Bartosz Faruga / MrRooby
  * @date 2025
  */
-class PaODisplayLine: protected LedElement {
+class PaODisplayLine: public LedElement {
     private:
-        RgbColor baseColor;
+        PaletteIndex baseColor = PALETTE_DISPLAY;
+
+        /** @brief Palette entry of the value field for a base entry (base + 1) */
+        static PaletteIndex valueColor(PaletteIndex color);
+
+        /** @brief Palette entry of the argument field for a base entry (base + 2) */
+        static PaletteIndex argumentColor(PaletteIndex color);
 
     public:
         TwoDigitDisplay *addr = nullptr;    ///< Address display (2 digits)
@@ -30,12 +36,12 @@ class PaODisplayLine: protected LedElement {
         TwoDigitDisplay *arg = nullptr;     ///< Argument display (2 digits)
 
         /**
-         * @brief Construct a new PAO Display Line using Channel 0 (RMT0)
+         * @brief Construct a new PAO Display Line
          * 
          * Initializes a PAO display line that controls three separate digit displays
-         * (address, value, argument) using RMT channel 0 of the ESP32.
+         * (address, value, argument) on the strip behind the given FrameBuffer.
          * 
-         * @param strip0 Pointer to the NeoPixelBus controller for RMT channel 0.
+         * @param frame Pointer to the FrameBuffer of the LED strip.
          *               Must not be nullptr.
          * @param startIndex The starting pixel index in the LED strip where this display begins.
          *                   Should be >= 0 and account for all pixels needed by the three displays.
@@ -47,27 +53,16 @@ class PaODisplayLine: protected LedElement {
          * @see displayLine()
          * @see setColor()
          */
-        PaODisplayLine(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt0Ws2812xMethod>* strip0, int startIndex, RgbColor color);    
-        
+        PaODisplayLine(FrameBuffer *frame, int startIndex, PaletteIndex color);
+
         /**
-         * @brief Construct a new PAO Display Line using Channel 1 (RMT1)
-         * 
-         * Initializes a PAO display line that controls three separate digit displays
-         * (address, value, argument) using RMT channel 1 of the ESP32.
-         * 
-         * @param strip1 Pointer to the NeoPixelBus controller for RMT channel 1.
-         *               Must not be nullptr.
-         * @param startIndex The starting pixel index in the LED strip where this display begins.
-         *                   Should be >= 0 and account for all pixels needed by the three displays.
-         * @param color The initial color to display on all three display components.
-         *              Can be changed later with setColor().
+         * @brief Destructor
          * 
-         * @note The constructor creates and initializes the three internal display objects
-         *       (addr, val, arg) automatically.
-         * @see displayLine()
-         * @see setColor()
+         * Deletes the address, value and argument displays.
          */
-        PaODisplayLine(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt1Ws2812xMethod>* strip1, int startIndex, RgbColor color);    
+        ~PaODisplayLine();
+
+        static const int TEXT_LENGTH = 7;   ///< Number of digits in a PAO line (address + value + argument)
 
         /**
          * @brief Display values on all three displays simultaneously
@@ -87,11 +82,13 @@ class PaODisplayLine: protected LedElement {
          *            Values > 999 will be clamped or wrapped by the underlying display.
          * @param arg Argument value to display (valid range: 0-99).
          *            Values > 99 will be clamped or wrapped by the underlying display.
+         * @param hex Show all three fields as hex digits (00-FF, 000-FFF) for machines
+         *            with more than 100 words or words wider than 999.
          * 
          * @note This method updates the internal display buffers and sends data to the LED strip.
          * @see loadingAnimation()
          */
-        void displayLine(int addr, int val, int arg);
+        void displayLine(int addr, int val, int arg, bool hex = false);
 
         void displayLettersOnAddrField(const char firstLetter, const char secondLetter);
         
@@ -99,6 +96,19 @@ class PaODisplayLine: protected LedElement {
 
         void displayLettersOnArgField(const char firstLetter, const char secondLetter);
 
+        /**
+         * @brief Display up to 7 characters across the address, value and argument fields
+         * 
+         * The characters fill the 2 + 3 + 2 digits from left to right. A shorter text
+         * leaves the remaining digits blank. Nothing is allocated, so the call is cheap
+         * enough to be repeated every frame for scrolling text.
+         * 
+         * @param text Null-terminated text; only the first TEXT_LENGTH characters are used
+         * 
+         * @see DisplayManager::scrollText()
+         */
+        void displayText(const char *text);
+
         /**
          * @brief Display a loading animation on the PAO display
          * 
@@ -118,21 +128,25 @@ class PaODisplayLine: protected LedElement {
          * Updates the color of the address, value, and argument displays simultaneously.
          * Useful for visual feedback (e.g., changing color on error, highlighting active display).
          * 
-         * Inherits color swapping behavior from LedElement if swappedRG flag is set.
+         * The address field uses the given entry, the value and argument fields use the
+         * two entries that follow it (e.g. PALETTE_DISPLAY, PALETTE_DISPLAY_ALT,
+         * PALETTE_DISPLAY_ALT_ARG).
          * 
-         * @param color New RgbColor to apply to all display components.
-         *              Example: RgbColor(255, 0, 0) for red.
+         * @param color Base palette entry (PALETTE_DISPLAY or PALETTE_HIGHLIGHT).
          * 
          * @note This overrides the base LedElement::setColor() method.
          * @see LedElement::setColor()
          */
-        void setColor(RgbColor color) override;
+        void setColor(PaletteIndex color) override;
+
+        /** @brief Forget the retained state of every digit */
+        void invalidate() override;
         
-        void applyColor(RgbColor color);
+        void applyColor(PaletteIndex color);
         
-        RgbColor getColor();
+        PaletteIndex getColor();
 
-        void setTemporaryColor(RgbColor color);
+        void setTemporaryColor(PaletteIndex color);
 
         void restoreColor();
 };
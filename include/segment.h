@@ -1,17 +1,16 @@
 #pragma once
 
-#include <NeoPixelBus.h>
-#include <map>
-#include <array>
 #include "led_element.h"
+#include "segment_font.h"
 
 /**
  * @file segment.h
  * @brief 7-segment LED display controller using NeoPixelBus
  * 
  * Provides control for individual 7-segment LED displays within NeoPixel LED strips.
- * Supports displaying digits 0-9 with customizable colors and animation effects.
- * Each segment is independently addressable on the LED strip.
+ * Supports displaying digits, hex values and text with customizable colors and animation
+ * effects. Glyphs come from the constexpr SegmentFont table and are written with one
+ * masked span write per digit.
  * 
  * Segment Layout:
  * ``` 
@@ -31,11 +30,11 @@
 class Segment : public LedElement
 {
 private:
-    int channel;
-
-    int currentFrame = 0;
+    uint8_t currentFrame = 0;
 
 public:
+    static const int BLANK = -1;    ///< Digit value that turns the segment off (see displayNumber())
+
     /**
      * @brief Default constructor
      * 
@@ -45,56 +44,46 @@ public:
     Segment();
 
     /**
-     * @brief Construct a Segment for Channel 0 (RMT0)
+     * @brief Construct a Segment
      *
-     * Initializes a 7-segment display that controls seven LEDs using the NeoEsp32Rmt0Ws2812xMethod
-     * (RMT channel 0) of the ESP32.
+     * Initializes a 7-segment display that controls seven LEDs of the strip
+     * behind the given FrameBuffer.
      *
-     * @param strip0 Pointer to the NeoPixelBus object configured for RMT channel 0.
+     * @param frame Pointer to the FrameBuffer of the LED strip.
      *               Must not be nullptr.
      * @param startIndex The starting index of the first LED (segment 'a') in the strip.
      *                   The segment uses 7 consecutive LEDs starting from this index.
-     * @param color The RgbColor to use for illuminating the segment.
+     * @param color The palette entry to use for illuminating the segment.
      *              Can be changed later with setColor().
      * 
      * @note Ensure startIndex + 7 does not exceed the total number of LEDs in the strip.
      * @see displayNumber()
      * @see setColor()
      */
-    Segment(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt0Ws2812xMethod>* strip0, int startIndex, RgbColor color);
-    
+    Segment(FrameBuffer *frame, int startIndex, PaletteIndex color);
+
     /**
-     * @brief Construct a Segment for Channel 1 (RMT1)
+     * @brief Display a digit (0-9, or 10-15 as hex A-F) on the 7-segment display
      *
-     * Initializes a 7-segment display that controls seven LEDs using the NeoEsp32Rmt1Ws2812xMethod
-     * (RMT channel 1) of the ESP32.
+     * Activates the appropriate LED segments to form the requested digit.
      *
-     * @param strip1 Pointer to the NeoPixelBus object configured for RMT channel 1.
-     *               Must not be nullptr.
-     * @param startIndex The starting index of the first LED (segment 'a') in the strip.
-     *                   The segment uses 7 consecutive LEDs starting from this index.
-     * @param color The RgbColor to use for illuminating the segment.
-     *              Can be changed later with setColor().
+     * @param number The digit to display (valid range: 0-15).
+     *               Values outside this range (e.g. Segment::BLANK) turn the digit off.
      * 
-     * @note Ensure startIndex + 7 does not exceed the total number of LEDs in the strip.
-     * @see displayNumber()
-     * @see setColor()
+     * @see SegmentFont::digit()
      */
-    Segment(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt1Ws2812xMethod>* strip1, int startIndex, RgbColor color);
+    void displayNumber(int number);
 
     /**
-     * @brief Display a digit (0-9) on the 7-segment display
+     * @brief Display an ASCII character on the 7-segment display
      *
-     * Activates the appropriate LED segments to form the requested digit.
-     * Uses standard 7-segment encoding to display digits 0-9.
+     * Letters, digits and the symbols that fit on seven segments are drawn from
+     * SegmentFont::GLYPHS; any other character turns the digit off.
      *
-     * @param number The digit to display (valid range: 0-9).
-     *               Values outside this range may result in no display or unpredictable behavior.
+     * @param letter Character to display (upper and lower case are both supported)
      * 
-     * @note The display updates the LED strip immediately with the new segments.
+     * @see SegmentFont::glyph()
      */
-    void displayNumber(int number);
-
     void displayLetter(const char letter);
 
     /**
@@ -111,4 +100,8 @@ public:
      * @see displayNumber()
      */
     void loadingAnimation();
+
+protected:
+    /** @brief Write a segment mask (bit n lights segment pixel n) */
+    void render(uint32_t state) override;
 };
\ No newline at end of file
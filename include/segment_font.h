@@ -0,0 +1,178 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @file segment_font.h
+ * @brief 7-segment glyph table for the whole 7-bit ASCII range
+ *
+ * Every glyph is a pixel mask for one Segment: bit n lights pixel n of the digit, so
+ * a character is rendered with a single LedElement::writeMask() call and no lookup
+ * structure has to be allocated. Characters that cannot be drawn on seven segments
+ * (K, M, V, W, X, most punctuation, control characters) map to a blank digit.
+ *
+ * Pixel order of a Segment (see segment.h):
+ * ```
+ *    --A--        A = pixel 2 (top)
+ *   |     |       B = pixel 1 (upper right)
+ *   F     B       C = pixel 6 (lower right)
+ *   |     |       D = pixel 5 (bottom)
+ *    --G--        E = pixel 4 (lower left)
+ *   |     |       F = pixel 3 (upper left)
+ *   E     C       G = pixel 0 (middle)
+ *   |     |
+ *    --D--
+ * ```
+ *
+ * Upper case B and D use the lower case shapes so hex values stay readable next to 8 and 0.
+ *
+ * @author Bartosz Faruga / MrRooby
+ * @date 2025
+ */
+namespace SegmentFont {
+    constexpr uint8_t A = 1 << 2;   ///< Top segment
+    constexpr uint8_t B = 1 << 1;   ///< Upper right segment
+    constexpr uint8_t C = 1 << 6;   ///< Lower right segment
+    constexpr uint8_t D = 1 << 5;   ///< Bottom segment
+    constexpr uint8_t E = 1 << 4;   ///< Lower left segment
+    constexpr uint8_t F = 1 << 3;   ///< Upper left segment
+    constexpr uint8_t G = 1 << 0;   ///< Middle segment
+
+    /// Glyph mask for every 7-bit ASCII code
+    constexpr uint8_t GLYPHS[128] = {
+        // 0x00 - 0x1F: control characters (blank)
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+
+        // 0x20 - 0x7E: printable characters
+        0,                          // ' '
+        0,                          // '!'
+        B | F,                      // '"'
+        0,                          // '#'
+        0,                          // '$'
+        0,                          // '%'
+        0,                          // '&'
+        B,                          // '\''
+        A | D | E | F,              // '('
+        A | B | C | D,              // ')'
+        0,                          // '*'
+        0,                          // '+'
+        0,                          // ','
+        G,                          // '-'
+        0,                          // '.'
+        B | E | G,                  // '/'
+        A | B | C | D | E | F,      // '0'
+        B | C,                      // '1'
+        A | B | D | E | G,          // '2'
+        A | B | C | D | G,          // '3'
+        B | C | F | G,              // '4'
+        A | C | D | F | G,          // '5'
+        A | C | D | E | F | G,      // '6'
+        A | B | C,                  // '7'
+        A | B | C | D | E | F | G,  // '8'
+        A | B | C | D | F | G,      // '9'
+        0,                          // ':'
+        0,                          // ';'
+        0,                          // '<'
+        D | G,                      // '='
+        0,                          // '>'
+        A | B | E | G,              // '?'
+        0,                          // '@'
+        A | B | C | E | F | G,      // 'A'
+        C | D | E | F | G,          // 'B'
+        A | D | E | F,              // 'C'
+        B | C | D | E | G,          // 'D'
+        A | D | E | F | G,          // 'E'
+        A | E | F | G,              // 'F'
+        A | C | D | E | F,          // 'G'
+        B | C | E | F | G,          // 'H'
+        B | C,                      // 'I'
+        B | C | D | E,              // 'J'
+        0,                          // 'K'
+        D | E | F,                  // 'L'
+        0,                          // 'M'
+        C | E | G,                  // 'N'
+        A | B | C | D | E | F,      // 'O'
+        A | B | E | F | G,          // 'P'
+        A | B | C | F | G,          // 'Q'
+        E | G,                      // 'R'
+        A | C | D | F | G,          // 'S'
+        D | E | F | G,              // 'T'
+        B | C | D | E | F,          // 'U'
+        0,                          // 'V'
+        0,                          // 'W'
+        0,                          // 'X'
+        B | C | D | F | G,          // 'Y'
+        A | B | D | E | G,          // 'Z'
+        A | D | E | F,              // '['
+        C | F | G,                  // '\\'
+        A | B | C | D,              // ']'
+        A | B | F,                  // '^'
+        D,                          // '_'
+        F,                          // '`'
+        A | B | C | D | E | G,      // 'a'
+        C | D | E | F | G,          // 'b'
+        D | E | G,                  // 'c'
+        B | C | D | E | G,          // 'd'
+        A | D | E | F | G,          // 'e'
+        A | E | F | G,              // 'f'
+        A | B | C | D | F | G,      // 'g'
+        C | E | F | G,              // 'h'
+        C,                          // 'i'
+        B | C | D,                  // 'j'
+        0,                          // 'k'
+        E | F,                      // 'l'
+        0,                          // 'm'
+        C | E | G,                  // 'n'
+        C | D | E | G,              // 'o'
+        A | B | E | F | G,          // 'p'
+        A | B | C | F | G,          // 'q'
+        E | G,                      // 'r'
+        A | C | D | F | G,          // 's'
+        D | E | F | G,              // 't'
+        C | D | E,                  // 'u'
+        0,                          // 'v'
+        0,                          // 'w'
+        0,                          // 'x'
+        B | C | D | F | G,          // 'y'
+        A | B | D | E | G,          // 'z'
+        0,                          // '{'
+        E | F,                      // '|'
+        0,                          // '}'
+        0,                          // '~'
+
+        // 0x7F: DEL (blank)
+        0
+    };
+
+    static_assert(sizeof(GLYPHS) == 128, "Segment font must cover the 7-bit ASCII range");
+
+    /**
+     * @brief Get the glyph mask of a character
+     *
+     * @param character ASCII character (codes above 127 are drawn blank)
+     *
+     * @return Segment pixel mask
+     */
+    constexpr uint8_t glyph(char character)
+    {
+        return (static_cast<uint8_t>(character) < 128) ? GLYPHS[static_cast<uint8_t>(character)] : 0;
+    }
+
+    /**
+     * @brief Get the glyph mask of a single decimal or hex digit
+     *
+     * @param digit Digit value (0-15)
+     *
+     * @return Segment pixel mask, or a blank digit for values outside 0-15
+     */
+    constexpr uint8_t digit(int digit)
+    {
+        return (digit >= 0 && digit < 10) ? GLYPHS['0' + digit]
+             : (digit >= 10 && digit < 16) ? GLYPHS['A' + digit - 10]
+             : 0;
+    }
+
+    static_assert(digit(8) == (A | B | C | D | E | F | G), "Segment font: digit 8 must light every segment");
+    static_assert(digit(0) != glyph('D') && digit(8) != glyph('B'), "Segment font: hex digits must differ from 0 and 8");
+}
@@ -13,9 +13,6 @@
  * @date 2025
  */
 class SignalLine : public LedElement {
-    private:
-        int length = 0;     ///< Number of LEDs in the signal line
-        int channel;
     public:
         /**
          * @brief Default constructor
@@ -26,46 +23,25 @@ class SignalLine : public LedElement {
         SignalLine();
 
         /**
-         * @brief Construct a SignalLine for Channel 0 (RMT0)
+         * @brief Construct a SignalLine
          * 
          * Initializes a signal line that controls a contiguous segment of LEDs on the specified
-         * strip using the NeoEsp32Rmt0Ws2812xMethod (RMT channel 0) of the ESP32.
+         * strip through the strip's FrameBuffer.
          * 
-         * @param strip0 Pointer to the NeoPixelBus object configured for RMT channel 0.
+         * @param frame Pointer to the FrameBuffer of the LED strip.
          *               Must not be nullptr.
          * @param startIndex The starting index of the first LED in the signal line.
          *                   Should be >= 0 and < total number of pixels.
          * @param length The number of consecutive LEDs to include in this signal line.
          *               Ensure startIndex + length does not exceed total strip LEDs.
-         * @param color The RgbColor to display when the signal is on.
+         * @param color The palette entry to display when the signal is on.
          *              Can be changed later with setColor().
          * 
          * @note All LEDs in the signal line display the same color when active.
          * @see turnOnLine()
          * @see setColor()
          */
-        SignalLine(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt0Ws2812xMethod>* strip0, int startIndex, int length, RgbColor color);
-        
-        /**
-         * @brief Construct a SignalLine for Channel 1 (RMT1)
-         * 
-         * Initializes a signal line that controls a contiguous segment of LEDs on the specified
-         * strip using the NeoEsp32Rmt1Ws2812xMethod (RMT channel 1) of the ESP32.
-         * 
-         * @param strip1 Pointer to the NeoPixelBus object configured for RMT channel 1.
-         *               Must not be nullptr.
-         * @param startIndex The starting index of the first LED in the signal line.
-         *                   Should be >= 0 and < total number of pixels.
-         * @param length The number of consecutive LEDs to include in this signal line.
-         *               Ensure startIndex + length does not exceed total strip LEDs.
-         * @param color The RgbColor to display when the signal is on.
-         *              Can be changed later with setColor().
-         * 
-         * @note All LEDs in the signal line display the same color when active.
-         * @see turnOnLine()
-         * @see setColor()
-         */
-        SignalLine(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt1Ws2812xMethod>* strip1, int startIndex, int length, RgbColor color);
+        SignalLine(FrameBuffer *frame, int startIndex, int length, PaletteIndex color);
 
         /**
          * @brief Turn the signal line on or off
@@ -74,10 +50,14 @@ class SignalLine : public LedElement {
          * Provides binary signal indication (active/inactive state) for machine signals.
          * 
          * @param choice true to turn on (set all LEDs to current color),
-         *               false to turn off (set all LEDs to black/RgbColor(0,0,0))
+         *               false to turn off (set all LEDs to PALETTE_OFF)
          * 
-         * @note The change is applied immediately to the LED strip.
+         * @note Nothing is written when the line already shows this state.
          * @see setColor()
          */
         void turnOnLine(bool choice);
+
+    protected:
+        /** @brief Fill the line with its color (state 1) or turn it off (state 0) */
+        void render(uint32_t state) override;
 };
\ No newline at end of file
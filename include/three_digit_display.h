@@ -23,10 +23,10 @@ class ThreeDigitDisplay : public LedElement {
 
     public:
         /**
-         * @brief Construct a ThreeDigitDisplay for Channel 0 (RMT0)
+         * @brief Construct a ThreeDigitDisplay
          * 
          * Initializes a three-digit seven-segment display that controls 21 LEDs (3 segments × 7 LEDs each)
-         * using the NeoEsp32Rmt0Ws2812xMethod (RMT channel 0) of the ESP32.
+         * of the strip behind the given FrameBuffer.
          * 
          * LED Layout:
          * ```
@@ -34,11 +34,11 @@ class ThreeDigitDisplay : public LedElement {
          * (Hundreds digit)    (Tens digit)        (Ones digit)
          * ```
          * 
-         * @param strip0 Pointer to the NeoPixelBus object configured for RMT channel 0.
+         * @param frame Pointer to the FrameBuffer of the LED strip.
          *               Must not be nullptr.
          * @param startIndex The starting index of the first LED in the display on the strip.
          *                   Should be >= 0 and account for all 21 LEDs needed (startIndex + 21 ≤ total LEDs).
-         * @param color The RgbColor to display for all three digits.
+         * @param color The palette entry to display for all three digits.
          *              Can be changed later with setColor().
          * 
          * @note The three internal Segment objects are automatically initialized starting at
@@ -46,34 +46,8 @@ class ThreeDigitDisplay : public LedElement {
          * @see displayValue()
          * @see setColor()
          */
-        ThreeDigitDisplay(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt0Ws2812xMethod>* strip1, int startIndex, RgbColor color);    
-        
-        /**
-         * @brief Construct a ThreeDigitDisplay for Channel 1 (RMT1)
-         * 
-         * Initializes a three-digit seven-segment display that controls 21 LEDs (3 segments × 7 LEDs each)
-         * using the NeoEsp32Rmt1Ws2812xMethod (RMT channel 1) of the ESP32.
-         * 
-         * **LED Layout:**
-         * ```
-         * [Segment 0: 7 LEDs] [Segment 1: 7 LEDs] [Segment 2: 7 LEDs]
-         * (Hundreds digit)    (Tens digit)        (Ones digit)
-         * ```
-         * 
-         * @param strip1 Pointer to the NeoPixelBus object configured for RMT channel 1.
-         *               Must not be nullptr.
-         * @param startIndex The starting index of the first LED in the display on the strip.
-         *                   Should be >= 0 and account for all 21 LEDs needed (startIndex + 21 ≤ total LEDs).
-         * @param color The RgbColor to display for all three digits.
-         *              Can be changed later with setColor().
-         * 
-         * @note The three internal Segment objects are automatically initialized starting at
-         *       startIndex, startIndex+7, and startIndex+14 respectively.
-         * @see displayValue()
-         * @see setColor()
-         */
-        ThreeDigitDisplay(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt1Ws2812xMethod>* strip1, int startIndex, RgbColor color);    
-        
+        ThreeDigitDisplay(FrameBuffer *frame, int startIndex, PaletteIndex color);
+
         /**
          * @brief Display a three-digit number on all segments
          * 
@@ -96,6 +70,15 @@ class ThreeDigitDisplay : public LedElement {
          * @see loadingAnimation()
          */
         void displayValue(int value, bool enableLeadingZero = true);
+
+        /**
+         * @brief Display a number as three hex digits (000-FFF)
+         * 
+         * Used instead of displayValue() when the machine words are wider than 999.
+         * 
+         * @param value Number to display, only the low 12 bits are shown
+         */
+        void displayHex(int value);
         
         void displayLetters(const char firstLetter, const char secondLetter, const char thirdLetter);
 
@@ -118,15 +101,16 @@ class ThreeDigitDisplay : public LedElement {
          * Updates the display color for all three seven-segment displays at once.
          * Useful for visual feedback (e.g., error indication, state highlighting).
          * 
-         * Inherits color swapping behavior from LedElement if swappedRG flag is set.
-         * 
-         * @param color New RgbColor to apply to all three digits.
-         *              Example: RgbColor(255, 0, 0) for red.
+         * @param color New palette entry to apply to all three digits.
+         *              Example: PALETTE_HIGHLIGHT.
          * 
          * @note This overrides the base LedElement::setColor() method.
          * @note Changes are applied to all three segment displays immediately.
          * @see LedElement::setColor()
          */
-        void setColor(RgbColor color) override;
+        void setColor(PaletteIndex color) override;
+
+        /** @brief Forget the retained state of every digit */
+        void invalidate() override;
 
 };
\ No newline at end of file
@@ -23,10 +23,10 @@ class TwoDigitDisplay : protected LedElement {
 
     public:
         /**
-         * @brief Construct a TwoDigitDisplay for Channel 0 (RMT0)
+         * @brief Construct a TwoDigitDisplay
          * 
          * Initializes a two-digit seven-segment display that controls 14 LEDs (2 segments × 7 LEDs each)
-         * using the NeoEsp32Rmt0Ws2812xMethod (RMT channel 0) of the ESP32.
+         * of the strip behind the given FrameBuffer.
          * 
          * **LED Layout:**
          * ```
@@ -34,11 +34,11 @@ class TwoDigitDisplay : protected LedElement {
          * (Tens digit)        (Ones digit)
          * ```
          * 
-         * @param strip0 Pointer to the NeoPixelBus object configured for RMT channel 0.
+         * @param frame Pointer to the FrameBuffer of the LED strip.
          *               Must not be nullptr.
          * @param startIndex The starting index of the first LED in the display on the strip.
          *                   Should be >= 0 and account for all 14 LEDs needed (startIndex + 14 ≤ total LEDs).
-         * @param color The RgbColor to display for both digits.
+         * @param color The palette entry to display for both digits.
          *              Can be changed later with setColor().
          * 
          * @note The two internal Segment objects are automatically initialized starting at
@@ -46,33 +46,7 @@ class TwoDigitDisplay : protected LedElement {
          * @see displayValue()
          * @see setColor()
          */
-        TwoDigitDisplay(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt0Ws2812xMethod>* strip0, int startIndex, RgbColor color);    
-
-        /**
-         * @brief Construct a TwoDigitDisplay for Channel 1 (RMT1)
-         * 
-         * Initializes a two-digit seven-segment display that controls 14 LEDs (2 segments × 7 LEDs each)
-         * using the NeoEsp32Rmt1Ws2812xMethod (RMT channel 1) of the ESP32.
-         * 
-         * **LED Layout:**
-         * ```
-         * [Segment 0: 7 LEDs] [Segment 1: 7 LEDs]
-         * (Tens digit)        (Ones digit)
-         * ```
-         * 
-         * @param strip1 Pointer to the NeoPixelBus object configured for RMT channel 1.
-         *               Must not be nullptr.
-         * @param startIndex The starting index of the first LED in the display on the strip.
-         *                   Should be >= 0 and account for all 14 LEDs needed (startIndex + 14 ≤ total LEDs).
-         * @param color The RgbColor to display for both digits.
-         *              Can be changed later with setColor().
-         * 
-         * @note The two internal Segment objects are automatically initialized starting at
-         *       startIndex and startIndex+7 respectively.
-         * @see displayValue()
-         * @see setColor()
-         */
-        TwoDigitDisplay(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt1Ws2812xMethod>* strip1, int startIndex, RgbColor color);    
+        TwoDigitDisplay(FrameBuffer *frame, int startIndex, PaletteIndex color);
 
         /**
          * @brief Display a two-digit number on both segments
@@ -96,6 +70,15 @@ class TwoDigitDisplay : protected LedElement {
          */
         void displayValue(int value, bool enableLeadingZero = true);
 
+        /**
+         * @brief Display a number as two hex digits (00-FF)
+         * 
+         * Used instead of displayValue() when the PAO has more than 100 words.
+         * 
+         * @param value Number to display, only the low 8 bits are shown
+         */
+        void displayHex(int value);
+
         void displayLetters(const char firstLetter, const char secondLetter);
 
         /**
@@ -117,14 +100,15 @@ class TwoDigitDisplay : protected LedElement {
          * Updates the display color for both seven-segment displays at once.
          * Useful for visual feedback (e.g., error indication, state highlighting).
          * 
-         * Inherits color swapping behavior from LedElement if swappedRG flag is set.
-         * 
-         * @param color New RgbColor to apply to both digits.
-         *              Example: RgbColor(255, 0, 0) for red.
+         * @param color New palette entry to apply to both digits.
+         *              Example: PALETTE_HIGHLIGHT.
          * 
          * @note This overrides the base LedElement::setColor() method.
          * @note Changes are applied to both segment displays immediately.
          * @see LedElement::setColor()
          */
-        void setColor(RgbColor color) override;
+        void setColor(PaletteIndex color) override;
+
+        /** @brief Forget the retained state of every digit */
+        void invalidate() override;
 };
\ No newline at end of file
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <stdint.h>
+#include "w_machine.h"
+
+/**
+ * @file w_history.h
+ * @brief Reverse execution of the W machine
+ *
+ * Records one W_Machine::Delta per TAKT and per register or memory edit: the XOR of the
+ * values before and after. Applying a delta again undoes it, and applying it once more
+ * redoes it, so stepping N TAKTs backwards or forwards costs N deltas. Every
+ * CHECKPOINT_INTERVAL deltas a full W_Machine::State is kept as well, and seek() starts
+ * long jumps from the nearest checkpoint instead of walking the deltas.
+ *
+ * The history is a position on a line of states: position n is the state after n deltas.
+ * Deltas and checkpoints live in fixed rings allocated with their owner, so the memory
+ * use is bounded: CAPACITY * sizeof(Delta) + CHECKPOINT_COUNT * sizeof(State), about
+ * 15 KiB for the default 5/8-bit machine. The oldest deltas are forgotten when the ring
+ * is full. Recording while an older position is shown discards the newer states, like
+ * an undo stack.
+ *
+ * @author Bartosz Faruga / MrRooby
+ * @date 2025
+ */
+
+/// @name History size build flags
+/// Override in platformio.ini, e.g. `-DW_HISTORY_TAKTS=4096` for a longer history.
+/// Both must be powers of 2.
+/// @{
+#ifndef W_HISTORY_TAKTS
+#define W_HISTORY_TAKTS 1024
+#endif
+
+#ifndef W_HISTORY_CHECKPOINT_INTERVAL
+#define W_HISTORY_CHECKPOINT_INTERVAL 64
+#endif
+/// @}
+
+class W_History
+{
+public:
+    static constexpr uint32_t CAPACITY = W_HISTORY_TAKTS;                          ///< Number of deltas kept
+    static constexpr uint32_t CHECKPOINT_INTERVAL = W_HISTORY_CHECKPOINT_INTERVAL; ///< Deltas between two checkpoints
+    static constexpr uint32_t CHECKPOINT_COUNT = CAPACITY / CHECKPOINT_INTERVAL + 1; ///< Checkpoints covering every kept delta
+
+    static_assert(CAPACITY > 0 && CHECKPOINT_INTERVAL > 0 && CHECKPOINT_INTERVAL <= CAPACITY,
+                  "W_History: the checkpoint interval must fit into the history");
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "W_History: W_HISTORY_TAKTS must be a power of 2");
+    static_assert((CHECKPOINT_INTERVAL & (CHECKPOINT_INTERVAL - 1)) == 0,
+                  "W_History: W_HISTORY_CHECKPOINT_INTERVAL must be a power of 2");
+
+    /// Position on the line of states; 64 bits, so it never wraps around (a 32-bit count wraps after hours of turbo)
+    using Position = uint64_t;
+
+private:
+    W_Machine::Delta deltas[CAPACITY];                      ///< Ring of deltas, delta n leads from position n to n + 1
+    W_Machine::State checkpoints[CHECKPOINT_COUNT];         ///< Ring of states at the multiples of CHECKPOINT_INTERVAL
+
+    Position oldest = 0;                                    ///< Position of the oldest state still reachable
+    Position newest = 0;                                    ///< Position of the newest state
+    Position position = 0;                                  ///< Position of the state in the machine
+
+    /** @brief Delta leading from a position to the next one */
+    const W_Machine::Delta& deltaAt(Position from) const;
+
+    /** @brief Checkpoint slot of a position (a multiple of CHECKPOINT_INTERVAL) */
+    static uint32_t checkpointSlot(Position checkpoint);
+
+public:
+    /**
+     * @brief Forget the whole history and start it at the current machine state
+     *
+     * @param machine Machine whose state becomes position 0
+     */
+    void reset(const W_Machine &machine);
+
+    /**
+     * @brief Append a delta after the current position
+     *
+     * Called by the machine after the change. Newer states are discarded, the oldest
+     * delta is forgotten when the ring is full, and a checkpoint is saved on the
+     * multiples of CHECKPOINT_INTERVAL.
+     *
+     * @param delta Change just made
+     * @param machine Machine in the state after the change
+     */
+    void record(const W_Machine::Delta &delta, const W_Machine &machine);
+
+    /**
+     * @brief Bring the machine to a position
+     *
+     * Walks the deltas from the current position or loads the nearest checkpoint
+     * first, whichever applies fewer deltas. The selected signals are kept.
+     *
+     * @param machine Machine showing the current position
+     * @param target Position to show, clamped to getOldest() .. getNewest()
+     *
+     * @return Number of deltas applied
+     */
+    uint32_t seek(W_Machine &machine, Position target);
+
+    /** @brief Undo one delta, false at the oldest position */
+    bool stepBack(W_Machine &machine);
+
+    /** @brief Redo one delta, false at the newest position */
+    bool stepForward(W_Machine &machine);
+
+    /** @brief Discard the states newer than the current position */
+    void truncate();
+
+    /** @brief Position of the state in the machine */
+    Position getPosition() const;
+
+    /** @brief Position of the newest state */
+    Position getNewest() const;
+
+    /** @brief Position of the oldest state still reachable */
+    Position getOldest() const;
+
+    /** @brief Check whether the machine shows the newest state */
+    bool isLive() const;
+
+    /** @brief Signals of the TAKT leading away from the current position, 0 if none */
+    SignalMask getNextSignals() const;
+};
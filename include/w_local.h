@@ -2,24 +2,28 @@
 
 #include "display_manager.h"
 #include "human_interface.h"
-#include <unordered_map>
-#include <vector>
-#include <bitset>
-#include <math.h>
+#include "w_machine.h"
+#include "w_sequencer.h"
+#include "w_trace.h"
+#include "w_history.h"
 
 /**
  * @file w_local.h
  * @brief Local machine control mode without network connectivity
  * 
  * Implements the local operation mode where the machine is controlled via physical
- * buttons, rotary encoder, and serial input. Manages machine state including registers,
- * signals, memory, and real-time display updates.
+ * buttons, rotary encoder, and serial input. The machine state itself lives in the
+ * W_Machine core; W_Local feeds it with input and draws its change notifications.
+ * W_Server runs the same engine in WiFi mode and feeds it the edits of its web clients.
  * 
  * **Features:**
  * @li Register manipulation (L, I, AK, A, S, JAML)
- * @li Signal execution with conflict detection
+ * @li Signal execution with conflict detection (rejected signals flash red)
  * @li Program-Address-Operand (PAO) memory display
  * @li Insert mode for value editing via rotary encoder
+ * @li Auto-clock mode running whole programs from the microprogram ROM
+ * @li Execution trace of the last TAKTs, streamed over USB serial
+ * @li Reverse execution: browse back and forth through the last TAKTs and edits
  * @li Serial debug interface
  * 
  * @author Bartosz Faruga / MrRooby
@@ -32,212 +36,188 @@ private:
     DisplayManager *dispMan = nullptr;                       ///< Pointer to display manager for hardware control
     HumanInterface *humInter = nullptr;                      ///< Pointer to human interface for input handling
 
-    using _3Bit = std::bitset<3>;
-    using _5Bit = std::bitset<5>;
-    using _8Bit = std::bitset<8>;
+    W_Machine machine;                                       ///< Machine core (registers, memory, signals)
+    W_Sequencer sequencer{machine};                          ///< Microprogram sequencer of the auto-clock mode
+    bool stopLit = false;                                    ///< STOP line currently lit
 
-    _5Bit busA;
-    _8Bit busS;
-    
-    _8Bit JAML;
-    _8Bit AK;
-    _5Bit A;
-    _8Bit S;
-    _8Bit I;
-    _5Bit L;
-    
-    _8Bit PaO[32];
-
-    /// Program-Address-Operand memory (64 entries)
-    /// Each entry contains a pair of (address, operand) values
-    /// Stores the instruction set for the machine
-    // std::pair<uint16_t, uint16_t> PaO[64] = {
-    //     {1, 1},   {2, 2},   {4, 4},   {8, 8},   {17, 17}, {34, 34}, {36, 36}, {56, 56},
-    //     {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},
-    //     {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},
-    //     {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},
-    //     {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},
-    //     {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},
-    //     {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},
-    //     {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0},   {0, 0}
-    // };
-
-    /// Signal state map (on/off state for each signal line)
-    /// Contains all 16 control signals used by the machine
-    std::unordered_map<std::string, bool> signal = {
-        {"IL",    false}, 
-        {"WEL",   false}, 
-        {"WYL",   false}, 
-        {"WYAD",  false}, 
-        {"WEI",   false}, 
-        {"WEAK",  false}, 
-        {"DOD",   false}, 
-        {"ODE",   false}, 
-        {"PRZEP", false}, 
-        {"WYAK",  false}, 
-        {"WEJA",  false}, 
-        {"WEA",   false}, 
-        {"CZYT",  false}, 
-        {"PISZ",  false}, 
-        {"WES",   false}, 
-        {"WYS",   false}    
-    };
+    static constexpr uint32_t TURBO_FRAME_MICROS = 1000000 / 30;   ///< Time between panel snapshots at the turbo speed (30 Hz)
+    static constexpr uint32_t TURBO_BURST_STEPS = 256;             ///< Steps run between two reads of the clock
+    static constexpr uint16_t TURBO_REPORT_MILLIS = 1000;          ///< Interval of the takts per second report
 
-    /// Data bus values (A and S buses)
-    // std::unordered_map<std::string, uint16_t> bus = {
-    //     {"A", 0},           ///< Address bus value
-    //     {"S", 0}            ///< Stack bus value
-    // };
+    W_Trace trace;                                           ///< Execution trace of the last W_Trace::CAPACITY takts
+    W_Trace::Cursor traceCursor;                             ///< Serial reader position in the trace
+    bool traceFollowing = false;                             ///< Stream every new takt to serial
+    bool traceDumping = false;                               ///< Stream the buffered takts up to traceDumpEnd
+    uint32_t traceDumpEnd = 0;                               ///< Entry number where the dump stops
+    static constexpr uint8_t TRACE_LINES_PER_LOOP = 8;       ///< Most trace lines written in one loop
 
-    std::unordered_map<std::string, bool> busLED = {
-        {"A", false},
-        {"S", false},
-    };
+    W_History history;                                       ///< Undo history of the last W_History::CAPACITY takts and edits
+    bool historyMode = false;                                ///< Encoder browses the history
+    SignalMask liveSignals = 0;                              ///< Signals selected when history mode was entered
 
-    const uint16_t BUS_LIGHT_UP_MILLIS = 690;
+    uint32_t turboTakts = 0;                                 ///< Takts run since the last turbo report
+    unsigned long turboReportTime = 0;                       ///< Time of the last turbo report
 
-    /// Queue of signals to execute on next TAKT
-    /// Stores selected signals before execution
-    std::vector<std::string> nextLineSignals;
+    /**
+     * @struct SignalView
+     * @brief Signal line element(s) showing one machine signal
+     */
+    struct SignalView {
+        SignalLine *DisplayManager::*line;                   ///< Line showing the signal
+        SignalLine *DisplayManager::*extraLine;              ///< Second line of the signal (WYAD), or nullptr
+    };
 
-    /// Function pointer type for signal command methods
-    using CommandFunction = void (W_Local::*)();
+    /// Signal lines of every machine signal, indexed by Signal
+    static const SignalView signalViews[Signals::COUNT];
 
-    /// Map of signal names to their corresponding command methods
-    /// Used for dynamic signal execution
-    static const std::unordered_map<std::string, CommandFunction> signalMap;
+    SignalMask drawnSignals = 0;                             ///< Signals whose lines are currently lit
+    MachineChanges lastChanges;                              ///< Changes drawn by the last refreshDisplay()
+    const uint16_t BUS_LIGHT_UP_MILLIS = 690;
 
-    /// Map of signal conflicts (signals that cannot be active simultaneously)
-    /// Maps signal name to list of conflicting signals
-    static const std::unordered_map<std::string, std::vector<std::string>> signalConflicts;
+    unsigned long busTurnOnTime[W_Machine::BUS_COUNT] = {};  ///< When each bus was last driven
+    bool busLit[W_Machine::BUS_COUNT] = {};                  ///< Bus lines currently lit
 
-    enum Register {
-        regL  = 0, 
-        regI  = 1, 
-        regAK = 2,
-        regA  = 3,
-        regS  = 4 
-    };
+    using Register = W_Machine::Register;
 
-    template<size_t N>
-    uint8_t binaryTo_uint8_t(std::bitset<N> number);
-    
     bool insertModeEnabled = false;                          ///< Flag indicating if insert/edit mode is active
     std::string selectedValue = "L";                         ///< Currently selected register in insert mode
 
-    char* lastPressedButton = nullptr;                       ///< Tracks last button pressed for debouncing
-
-    uint8_t PaORangeLow  = 0;
-    
-    uint8_t getPaOAddr();
-
-    void initRegisters();
-
-    /// @name Signal Command Methods
-    /// These methods implement the actual machine operations when signals are executed
-    /// @{
-
-    /** @brief IL (Instruction Load) - Increment the L (counter) register */
-    void il();
-
-    /** @brief WEL (Write Enable Line) - Transfer value from bus A to register L */
-    void wel();
-
-    /** @brief WYL (Write Output Line) - Transfer value from register L to bus A */
-    void wyl();
-
-    /** @brief WYAD (Write Address) - Transfer value from register I to bus A */
-    void wyad();
-
-    /** @brief WEI (Write Enable Input) - Transfer value from bus S to register I */
-    void wei();
-
-    /** @brief WEAK (Write Enable AK) - Transfer value from register JAML to register AK */
-    void weak();
-
-    /** @brief DOD (Increment) - Add AK to JAML and store result */
-    void dod();
-
-    /** @brief ODE (Decrement) - Subtract AK from JAML and store result */
-    void ode();
-
-    /** @brief PRZEP (Transfer) - Transfer value from register JAML to register AK */
-    void przep();
-
-    /** @brief WYAK (Write Output AK) - Transfer value from register AK to bus S */
-    void wyak();
-
-    /** @brief WEJA (Write Enable JA) - Transfer value from bus S to register JAML */
-    void weja();
+    const PanelButton* lastPressedButton = nullptr;          ///< Tracks last button pressed for debouncing
 
-    /** @brief WEA (Write Enable A) - Transfer value from bus A to register A (with range check 0-63) */
-    void wea();
+    static constexpr uint8_t PAO_ROWS = 4;                   ///< Number of PAO rows on the panel
 
-    /** @brief CZYT (Read) - Read from PAO memory at address A into register S */
-    void czyt();
+    /// Show addresses and words as hex when they do not fit the decimal digits of the panel
+    static constexpr bool HEX_DISPLAY = W_Machine::MEMORY_SIZE > 100 || W_Machine::GEOMETRY.wordMask() > 999;
 
-    /** @brief PISZ (Write) - Write to PAO memory at address A from register S */
-    void pisz();
+    static_assert(W_Machine::GEOMETRY.addressBits <= 8 && W_Machine::GEOMETRY.wordBits <= 12,
+                  "W_Local: addresses must fit two and words three hex digits of the panel");
+    static_assert(W_Machine::MEMORY_SIZE >= PAO_ROWS, "W_Local: the PAO must fill the rows of the panel");
 
-    /** @brief WES (Write Enable Stack) - Transfer value from register S to bus S */
-    void wes();
-
-    /** @brief WYS (Write Output Stack) - Transfer value from register S to bus S */
-    void wys();
-
-    /// @}
+    uint16_t PaORangeLow = 0;                                ///< Address shown in the first PAO row
+    
+    uint8_t PaORangeHighlight = 0xFF;                        ///< PAO row last drawn highlighted (0xFF = none)
+    bool PaOViewChanged = true;                              ///< Set when the visible PAO rows were scrolled
 
     /**
-     * @brief Execute all queued signals in sequence
+     * @brief Update the displays whose machine state changed
      * 
-     * Executes each signal in the nextLineSignals queue by calling their corresponding
-     * command methods. After execution, clears all signal states and the queue.
+     * Takes the change set of the machine core and redraws only the registers,
+     * signal lines and PAO rows listed in it. Display elements keep their last drawn
+     * state, so an idle machine writes no pixels. Calls dispMan->refreshDisplay()
+     * at the end.
      * 
-     * Only executes if the queue is not empty.
+     * @note Called every loop iteration to keep display synchronized
      */
-    void takt();
+    void refreshDisplay();
+
+    /** @brief Redraw the visible PAO rows that changed (memory, highlight or scrolling) */
+    void refreshPaOLines(const MachineChanges &changes);
 
     /**
-     * @brief Update all displays with current machine state
+     * @brief Light the bus lines that were driven and turn them off after BUS_LIGHT_UP_MILLIS
      * 
-     * Refreshes all connected displays (three-digit displays, signal lines, bus lines, PAO displays)
-     * with the current machine state values. Calls dispMan->refreshDisplay() at the end.
-     * 
-     * @note Called every loop iteration to keep display synchronized
+     * @param buses Bit n set when W_Machine::Bus n was driven since the last call
      */
-    void refreshDisplay();
-
-    void refreshBUSLines();
+    void refreshBUSLines(uint8_t buses);
 
     /**
      * @brief Read and process button/encoder input from hardware
      * 
      * Polls the human interface for button presses and manages the signal queue:
      * @li TAKT button → Executes queued signals immediately
-     * @li Signal button → Toggles signal in queue (add if not present, remove if present)
+     * @li TAKT button with no signals selected → Starts the auto-clock mode
+     * @li TAKT button in auto-clock mode → Stops the clock (signal buttons are ignored while it runs)
+     * @li Any button in history mode → Continues from the shown state (resumeFromHistory())
+     * @li Signal button → Toggles signal in the machine core (add if not present, remove if present)
      * @li Implements debouncing via lastPressedButton tracking
      * 
      * @note Called every loop iteration
      */
     void readButtonInputs();
 
+    /**
+     * @brief Handle the TAKT button
+     * 
+     * Executes the selected signals, starts the auto-clock when none are selected, or
+     * stops the clock while it runs.
+     */
+    void pressTakt();
+
+    /**
+     * @brief Handle a signal button: toggle the signal in the machine core
+     * 
+     * A signal that conflicts with the selected ones flashes red. Ignored while the
+     * clock runs.
+     */
+    void pressSignal(Signal signal);
+
+    /**
+     * @brief Flash the line(s) of a rejected signal red
+     * 
+     * @param signal Signal rejected by the conflict matrix
+     */
+    void flashRejectedSignal(Signal signal);
+
     /**
      * @brief Handle value modification in insert mode via rotary encoder
      * 
      * Allows the user to increment/decrement the currently selected register value
-     * using the rotary encoder. Values wrap around (0 ↔ 999).
+     * using the rotary encoder. Values wrap around at the register width.
      * 
-     * @param value Reference to the register value to modify
+     * @param selectedRegister Register to modify
      * 
      * **Encoder behavior:**
-     * @li UP rotation → Increment value (wrap 999→0)
-     * @li DOWN rotation → Decrement value (wrap 0→999)
+     * @li DOWN rotation → Increment value
+     * @li UP rotation → Decrement value
      */
-    template<size_t N>
-    void insertMode(std::bitset<N> &selectedRegister);
+    void insertMode(Register selectedRegister);
 
     void scrollPaO();
 
+    /**
+     * @brief Change the auto-clock speed with the rotary encoder
+     * 
+     * @li DOWN rotation → Faster, up to W_Sequencer "MAX"
+     * @li UP rotation → Slower, down to 0.5 Hz
+     */
+    void changeClockSpeed();
+
+    /**
+     * @brief Run the machine at the turbo speed for one panel frame
+     * 
+     * Runs bursts of sequencer steps for TURBO_FRAME_MICROS without drawing anything,
+     * so the following refreshDisplay() draws one snapshot of all the changes. Prints
+     * the achieved takts per second every TURBO_REPORT_MILLIS.
+     */
+    void runTurbo();
+
+    /**
+     * @brief Enter or leave history mode
+     * 
+     * Leaving brings the machine back to the newest state with the signals that were
+     * selected. Does nothing while the clock runs.
+     */
+    void toggleHistoryMode();
+
+    /**
+     * @brief Step through the history with the rotary encoder
+     * 
+     * Every detent applies one delta, so the panel follows the encoder without lag. The
+     * signal lines show the signals of the TAKT that follows the shown state.
+     * 
+     * @li UP rotation → One TAKT back
+     * @li DOWN rotation → One TAKT forward
+     */
+    void browseHistory();
+
+    /**
+     * @brief Continue from the state shown in history mode
+     * 
+     * Discards the newer states and leaves history mode. The signals of the following
+     * TAKT stay selected, so TAKT executes it again.
+     */
+    void resumeFromHistory();
+
     /**
      * @brief Get the display pointer for the currently selected register
      * 
@@ -259,11 +239,34 @@ private:
      * @li Short-press encoder button → Select next register (cycles through all registers)
      * @li Encoder rotation → Modify selected register value
      * @li Blinking animation → Indicates currently selected register
+     * @li Encoder rotation outside insert mode → Scroll the PAO, or set the clock speed
+     *     while the auto-clock runs
+     * @li Short-press encoder button outside insert mode → Toggle history mode, where
+     *     rotation steps through the history (see browseHistory())
      * 
-     * @note Called every loop iteration when not in WiFi mode
+     * @note Called every loop iteration
      */
     void handleEncoderMode();
 
+    /**
+     * @brief Process single-character serial commands
+     * 
+     * @li 't' → Start/stop streaming every new takt of the trace
+     * @li 'd' → Dump the takts held in the trace
+     * 
+     * Then writes the pending trace lines with streamTrace().
+     */
+    void handleSerialDebug();
+
+    /**
+     * @brief Write the next trace lines to serial without blocking
+     * 
+     * Writes at most TRACE_LINES_PER_LOOP lines and only as many as fit into the serial
+     * transmit buffer, so execution never waits for the host. Takts overwritten before
+     * they were sent are reported as dropped.
+     */
+    void streamTrace();
+
     /**
      * @brief Print current machine state to serial console
      * 
@@ -276,25 +279,6 @@ private:
      */
     void printValuesToSerial();
 
-    /**
-     * @brief Validate that a signal can be added without conflicts
-     * 
-     * Checks if the new signal conflicts with any currently active signals
-     * in the nextLineSignals queue using the signalConflicts map.
-     * 
-     * **Conflict examples:**
-     * @li CZYT ↔ PISZ (cannot read and write simultaneously)
-     * @li DOD ↔ ODE ↔ PRZEP (cannot increment, decrement, and transfer simultaneously)
-     * 
-     * @param newSignal Name of the signal to validate
-     * 
-     * @return true if signal can be added (no conflicts), false otherwise
-     * 
-     * @note Prints debug message to serial on conflict detection
-     * @see signalConflicts
-     */
-    bool isSignalValid(const std::string &newSignal);
-
 public:
     /**
      * @brief Construct a new W_Local machine controller
@@ -322,10 +306,52 @@ public:
      * @li handleSerialDebug() - Process serial commands
      * @li handleEncoderMode() - Handle register editing
      * @li readButtonInputs() - Read button/encoder input
+     * @li W_Sequencer::update() or runTurbo() - Run the auto-clock steps that are due
      * @li refreshDisplay() - Update all displays
      * @li printValuesToSerial() - Output state to serial
      * 
      * @note Should be called continuously from main loop when in local mode
      */
     void runLocal();
+
+    /// @name Remote Control
+    /// Used by W_Server, which runs the machine with runLocal() and applies the edits of
+    /// its web clients here. An edit that matches the current state does nothing, so a
+    /// client echoing the state it was sent does not leave history mode.
+    /// @{
+
+    /**
+     * @brief Select or deselect a signal the way its panel button does
+     * 
+     * @param signal Signal to change
+     * @param active true to select it
+     */
+    void setSignal(Signal signal, bool active);
+
+    /** @brief Write a register, as in insert mode */
+    void setRegister(Register reg, uint32_t value);
+
+    /** @brief Write a memory word */
+    void setMemory(uint32_t address, uint32_t value);
+
+    /**
+     * @brief Draw the whole panel again on the next runLocal()
+     * 
+     * For a panel that was cleared or drawn over (loading animation, IP address).
+     */
+    void redrawPanel();
+
+    /** @brief Machine core, for reading the state */
+    const W_Machine& getMachine() const { return this->machine; }
+
+    /** @brief Changes drawn by the last runLocal() */
+    const MachineChanges& getLastChanges() const { return this->lastChanges; }
+
+    /** @brief Button held during the last runLocal(), or nullptr */
+    const PanelButton* getPressedButton() const { return this->lastPressedButton; }
+
+    /** @brief Check whether the STOP line is lit */
+    bool isStopLit() const { return this->stopLit; }
+
+    /// @}
 };
\ No newline at end of file
@@ -0,0 +1,488 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <bitset>
+#include <type_traits>
+#include "w_signals.h"
+#include "w_trace.h"
+
+class W_History;
+
+/// @name Machine geometry build flags
+/// The default is the 5-bit address / 8-bit word / 3-bit opcode teaching machine.
+/// Labs with a larger memory override them in platformio.ini, e.g.
+/// `-DW_ADDRESS_BITS=8 -DW_WORD_BITS=11` for 256 words.
+/// @{
+#ifndef W_ADDRESS_BITS
+#define W_ADDRESS_BITS 5
+#endif
+
+#ifndef W_WORD_BITS
+#define W_WORD_BITS 8
+#endif
+
+#ifndef W_OPCODE_BITS
+#define W_OPCODE_BITS 3
+#endif
+/// @}
+
+/**
+ * @struct MachineGeometry
+ * @brief Bit widths of the W machine
+ *
+ * A memory word holds an address in its low addressBits and the instruction code
+ * (opcode) in the opcodeBits above it. Registers holding addresses (A, L, bus A) are
+ * addressBits wide, registers holding words (S, I, AK, JAML, bus S) are wordBits wide.
+ */
+struct MachineGeometry {
+    uint8_t addressBits;    ///< Width of an address
+    uint8_t wordBits;       ///< Width of a memory word
+    uint8_t opcodeBits;     ///< Width of the instruction code
+
+    /** @brief Mask of the address bits of a word */
+    constexpr uint32_t addressMask() const { return (1UL << addressBits) - 1; }
+
+    /** @brief Mask of all bits of a word */
+    constexpr uint32_t wordMask() const { return (wordBits >= 32) ? 0xFFFFFFFFUL : (1UL << wordBits) - 1; }
+
+    /** @brief Mask of the instruction code, shifted down to bit 0 */
+    constexpr uint32_t opcodeMask() const { return (1UL << opcodeBits) - 1; }
+
+    /** @brief Number of words in the memory */
+    constexpr uint32_t memorySize() const { return 1UL << addressBits; }
+
+    /** @brief Instruction code of a word */
+    constexpr uint32_t opcode(uint32_t word) const { return (word >> addressBits) & opcodeMask(); }
+
+    /** @brief Address field of a word */
+    constexpr uint32_t address(uint32_t word) const { return word & addressMask(); }
+
+    /** @brief Check that the fields fit into a word and the memory fits into the ESP32 */
+    constexpr bool isValid() const
+    {
+        return addressBits > 0 && addressBits <= 12 && opcodeBits > 0 &&
+               addressBits + opcodeBits <= wordBits && wordBits <= 32;
+    }
+};
+
+/// Geometry of the machine built into the firmware
+constexpr MachineGeometry W_GEOMETRY = {W_ADDRESS_BITS, W_WORD_BITS, W_OPCODE_BITS};
+
+static_assert(W_GEOMETRY.isValid(), "Machine geometry: opcode and address must fit into a word (at most 12 address bits)");
+
+/**
+ * @struct MachineChanges
+ * @brief Parts of the machine state that changed since the last W_Machine::takeChanges()
+ *
+ * The machine core raises a change notification by setting a bit here whenever a
+ * register, a signal or a memory cell gets a new value, or a bus is driven. The
+ * front ends (W_Local) only redraw what is listed, so an idle machine costs nothing
+ * to display.
+ */
+struct MachineChanges {
+    uint8_t registers = 0;      ///< Bit n set when W_Machine::Register n changed
+    uint8_t buses     = 0;      ///< Bit n set when W_Machine::Bus n was driven
+    bool signals      = false;  ///< Set when the selected signal set changed
+    std::bitset<W_GEOMETRY.memorySize()> memory;    ///< Bit n set when memory cell n changed
+
+    /** @brief Check whether anything changed */
+    bool any() const { return registers || buses || signals || memory.any(); }
+
+    /** @brief Add the changes of another set */
+    void merge(const MachineChanges &other)
+    {
+        registers |= other.registers;
+        buses     |= other.buses;
+        signals   |= other.signals;
+        memory    |= other.memory;
+    }
+};
+
+/**
+ * @file w_machine.h
+ * @brief Hardware independent core of the W machine
+ *
+ * Holds the machine state (registers, buses, PAO memory and the signals selected for
+ * the next TAKT) and executes the signal commands. The core has no Arduino dependency,
+ * so the same code drives the LED panel in W_Local and can be built and measured on
+ * the host (see helpers/).
+ *
+ * Every state change is recorded in a MachineChanges set, which the front end takes
+ * once per loop to redraw only the affected display elements.
+ *
+ * @author Bartosz Faruga / MrRooby
+ * @date 2025
+ */
+class W_Machine
+{
+public:
+    /**
+     * @enum Register
+     * @brief Machine registers, in the order used by the insert mode
+     */
+    enum Register : uint8_t {
+        regL    = 0,
+        regI    = 1,
+        regAK   = 2,
+        regA    = 3,
+        regS    = 4,
+        regJAML = 5,
+        REGISTER_COUNT
+    };
+
+    /**
+     * @enum Bus
+     * @brief Machine buses
+     */
+    enum Bus : uint8_t {
+        BUS_A = 0,
+        BUS_S = 1,
+        BUS_COUNT
+    };
+
+    /// Geometry of the machine (see W_ADDRESS_BITS, W_WORD_BITS, W_OPCODE_BITS)
+    static constexpr MachineGeometry GEOMETRY = W_GEOMETRY;
+
+    static constexpr uint32_t MEMORY_SIZE = GEOMETRY.memorySize();  ///< Number of words in the PAO memory
+
+    /// Smallest native integer holding one register or memory word
+    using Word = std::conditional_t<(GEOMETRY.wordBits <= 8),  uint8_t,
+                 std::conditional_t<(GEOMETRY.wordBits <= 16), uint16_t, uint32_t>>;
+
+    /**
+     * @struct State
+     * @brief Full copy of the registers, buses and memory (a history checkpoint)
+     */
+    struct State {
+        Word registers[REGISTER_COUNT];     ///< Register values, indexed by Register
+        Word bus[BUS_COUNT];                ///< Bus values, indexed by Bus
+        Word memory[MEMORY_SIZE];           ///< PAO memory
+    };
+
+    /**
+     * @struct Delta
+     * @brief Change made by one TAKT or one edit, as the XOR of the values before and after
+     *
+     * Applying a delta toggles the machine between the state before and the state after,
+     * so the same record steps backwards and forwards. A TAKT writes at most one memory
+     * word (PISZ), so one cell is enough.
+     */
+    struct Delta {
+        Word registers[REGISTER_COUNT];     ///< Register values before XOR after
+        Word bus[BUS_COUNT];                ///< Bus values before XOR after
+        Word memory;                        ///< Memory word at address before XOR after
+        uint16_t address;                   ///< Memory address the delta covers
+        SignalMask signals;                 ///< Signals executed, 0 for an edit
+    };
+
+private:
+    /// Mask of every register, indexed by Register
+    static constexpr Word REGISTER_MASK[REGISTER_COUNT] = {
+        GEOMETRY.addressMask(),     // L
+        GEOMETRY.wordMask(),        // I
+        GEOMETRY.wordMask(),        // AK
+        GEOMETRY.addressMask(),     // A
+        GEOMETRY.wordMask(),        // S
+        GEOMETRY.wordMask(),        // JAML
+    };
+
+    /// Mask of every bus, indexed by Bus
+    static constexpr Word BUS_MASK[BUS_COUNT] = {
+        GEOMETRY.addressMask(),     // A
+        GEOMETRY.wordMask(),        // S
+    };
+
+    Word registers[REGISTER_COUNT] = {};                     ///< Register values, indexed by Register
+    Word bus[BUS_COUNT] = {};                                ///< Bus values, indexed by Bus
+
+    Word PaO[MEMORY_SIZE] = {};                              ///< PAO memory, one native Word per cell
+
+    SignalMask selected = 0;                                 ///< Signals selected for the next TAKT
+
+    /**
+     * @struct Schedule
+     * @brief Execution order of one set of signals
+     */
+    struct Schedule {
+        SignalMask signals = 0;                              ///< Signal set the schedule belongs to
+        uint8_t count = 0;                                   ///< Number of entries in order
+        Signal order[Signals::COUNT] = {};                   ///< Signals in phase order
+    };
+
+    static constexpr uint8_t SCHEDULE_CACHE_SIZE = 8;        ///< Number of cached schedules (power of 2)
+
+    Schedule schedules[SCHEDULE_CACHE_SIZE];                 ///< Recently used schedules, direct-mapped by signal set
+
+    /** @brief Cache slot of a signal set */
+    static uint8_t scheduleSlot(SignalMask signals);
+
+    /**
+     * @brief Schedule of a signal set, compiled on a cache miss
+     *
+     * @param signals Signal set to execute
+     *
+     * @return Signals of the set in Signals::EXECUTION_ORDER
+     */
+    const Schedule& scheduleOf(SignalMask signals);
+
+    /// Function pointer type for signal command methods
+    using CommandFunction = void (W_Machine::*)();
+
+    /// Command method of every signal, indexed by Signal
+    static const CommandFunction COMMANDS[Signals::COUNT];
+
+    MachineChanges changes;                                  ///< Changes collected since the last takeChanges()
+
+    W_Trace *trace = nullptr;                                ///< Trace receiving one entry per TAKT, or nullptr
+
+    W_History *history = nullptr;                            ///< History receiving one delta per TAKT and edit, or nullptr
+
+    /**
+     * @brief Store a new register value and record the change
+     *
+     * @param target Register to write (its change bit is set only when the value differs)
+     * @param value New value, truncated to the width of the register
+     */
+    void write(Register target, uint32_t value);
+
+    /**
+     * @brief Store a new bus value and record that the bus was driven
+     *
+     * @param target Bus to drive
+     * @param value New value, truncated to the width of the bus
+     */
+    void drive(Bus target, uint32_t value);
+
+    /**
+     * @brief Store a memory word and record the change
+     *
+     * @param address Address, already wrapped to the memory size
+     * @param value New value, truncated to the width of a word
+     */
+    void store(uint32_t address, uint32_t value);
+
+    /**
+     * @brief Start a history delta: copy the current values
+     *
+     * @param delta Delta to fill
+     * @param address Memory cell the following change may write
+     */
+    void beginDelta(Delta &delta, uint32_t address) const;
+
+    /**
+     * @brief Finish a history delta (XOR with the new values) and record it
+     *
+     * @param delta Delta started with beginDelta()
+     * @param signals Signals executed, 0 for an edit
+     */
+    void commitDelta(Delta &delta, SignalMask signals);
+
+    /// @name Signal Command Methods
+    /// These methods implement the actual machine operations when signals are executed
+    /// @{
+
+    /** @brief IL (Instruction Load) - Increment the L (counter) register */
+    void il();
+
+    /** @brief WEL (Write Enable Line) - Transfer value from bus A to register L */
+    void wel();
+
+    /** @brief WYL (Write Output Line) - Transfer value from register L to bus A */
+    void wyl();
+
+    /** @brief WYAD (Write Address) - Transfer value from register I to bus A */
+    void wyad();
+
+    /** @brief WEI (Write Enable Input) - Transfer value from bus S to register I */
+    void wei();
+
+    /** @brief WEAK (Write Enable AK) - Transfer value from register JAML to register AK */
+    void weak();
+
+    /** @brief DOD (Add) - Add JAML to AK and store the result in AK */
+    void dod();
+
+    /** @brief ODE (Subtract) - Subtract JAML from AK and store the result in AK */
+    void ode();
+
+    /** @brief PRZEP (Transfer) - Transfer value from register JAML to register AK */
+    void przep();
+
+    /** @brief WYAK (Write Output AK) - Transfer value from register AK to bus S */
+    void wyak();
+
+    /** @brief WEJA (Write Enable JA) - Transfer value from bus S to register JAML */
+    void weja();
+
+    /** @brief WEA (Write Enable A) - Transfer value from bus A to register A (with range check 0-63) */
+    void wea();
+
+    /** @brief CZYT (Read) - Read from PAO memory at address A into register S */
+    void czyt();
+
+    /** @brief PISZ (Write) - Write to PAO memory at address A from register S */
+    void pisz();
+
+    /** @brief WES (Write Enable Stack) - Transfer value from register S to bus S */
+    void wes();
+
+    /** @brief WYS (Write Output Stack) - Transfer value from register S to bus S */
+    void wys();
+
+    /// @}
+
+public:
+    /**
+     * @brief Construct a machine with all registers, buses and memory cleared
+     *
+     * Every part of the state starts as changed, so the first takeChanges() makes
+     * the front end draw the whole panel.
+     */
+    W_Machine();
+
+    /**
+     * @brief Reset registers, buses, memory and selected signals to 0
+     */
+    void reset();
+
+    /**
+     * @brief Execute all selected signals
+     *
+     * Calls the command method of each selected signal from the COMMANDS table, phase
+     * by phase (Signals::Phase): memory read, bus drivers, ALU input, ALU and memory
+     * write, latches. The result does not depend on the order the signals were
+     * selected in, e.g. WEL before WYL still loads L from the new bus A. The schedule
+     * of a signal set is cached, so repeated TAKTs do not sort again. After execution
+     * the selection is cleared.
+     *
+     * Only executes if at least one signal is selected. When a trace is attached, the
+     * TAKT is recorded in it.
+     */
+    void takt();
+
+    /**
+     * @brief Select or deselect a signal for the next TAKT
+     *
+     * A signal that is already selected is removed. Otherwise it is selected if it
+     * does not conflict with the signals already selected.
+     *
+     * @param signal Signal to toggle
+     * @param conflict Optional output, receives the conflicting signal when the
+     *                 signal is rejected
+     *
+     * @return false if the signal was rejected because of a conflict
+     */
+    bool toggleSignal(Signal signal, Signal *conflict = nullptr);
+
+    /**
+     * @brief Validate that a signal can be added without conflicts
+     *
+     * One AND of the signal's Signals::CONFLICTS mask with the selected mask.
+     *
+     * **Conflict examples:**
+     * @li CZYT ↔ PISZ (cannot read and write simultaneously)
+     * @li WYAK ↔ WYS, WYL ↔ WYAD (two drivers on one bus)
+     * @li DOD ↔ ODE ↔ PRZEP ↔ WEAK (one writer of AK per TAKT)
+     * @li CZYT ↔ WES (one writer of S per TAKT)
+     *
+     * @param signal Signal to validate
+     * @param conflict Optional output, receives the lowest conflicting signal
+     *
+     * @return true if signal can be added (no conflicts), false otherwise
+     *
+     * @see Signals::conflicts()
+     */
+    bool isSignalValid(Signal signal, Signal *conflict = nullptr) const;
+
+    /**
+     * @brief Replace the selected signals with a precompiled step
+     *
+     * Used by the sequencer: the step was checked for conflicts and sorted by phase
+     * when it was compiled, so no checks are made here and the order is stored as the
+     * cached schedule of the signal set.
+     *
+     * @param signals Mask of the signals
+     * @param order Signals of the mask in Signals::EXECUTION_ORDER
+     * @param count Number of entries in order
+     */
+    void loadSignals(SignalMask signals, const Signal *order, uint8_t count);
+
+    /** @brief Deselect all signals selected for the next TAKT */
+    void clearSignals();
+
+    /** @brief Check whether a signal is selected for the next TAKT */
+    bool isSignalActive(Signal signal) const;
+
+    /** @brief Signals selected for the next TAKT */
+    SignalMask getSelectedSignals() const;
+
+    /** @brief Read a register */
+    Word getRegister(Register reg) const;
+
+    /**
+     * @brief Write a register
+     *
+     * @param reg Register to write
+     * @param value New value, truncated to the width of the register
+     */
+    void setRegister(Register reg, uint32_t value);
+
+    /** @brief Read a memory word (addresses wrap around the memory size) */
+    Word getMemory(uint32_t address) const;
+
+    /** @brief Write a memory word (addresses wrap around the memory size) */
+    void setMemory(uint32_t address, uint32_t value);
+
+    /** @brief Copy the registers, buses and memory */
+    void saveState(State &state) const;
+
+    /**
+     * @brief Replace the registers, buses and memory
+     *
+     * Only the parts that differ are marked as changed, so the panel redraws just them.
+     * The selected signals are kept.
+     */
+    void loadState(const State &state);
+
+    /**
+     * @brief Toggle the machine between the states before and after a delta
+     *
+     * The selected signals are kept.
+     */
+    void applyDelta(const Delta &delta);
+
+    /**
+     * @brief Select a set of signals without conflict checks
+     *
+     * Used to show the signals of a recorded TAKT while browsing the history; the set
+     * was conflict-free when it executed.
+     */
+    void restoreSignals(SignalMask signals);
+
+    /**
+     * @brief Return the changes collected since the last call and start a new set
+     *
+     * @return Registers, buses, memory cells and signals that changed
+     */
+    MachineChanges takeChanges();
+
+    /** @brief Mark the whole state as changed (e.g. after the panel was cleared) */
+    void markAllChanged();
+
+    /**
+     * @brief Record every following TAKT in a trace
+     *
+     * @param trace Trace to record into, nullptr to stop recording. Must outlive the machine
+     *              or be detached first.
+     */
+    void attachTrace(W_Trace *trace);
+
+    /**
+     * @brief Record every following TAKT and register or memory edit in a history
+     *
+     * @param history History to record into, nullptr to stop recording. Must outlive the
+     *                machine or be detached first.
+     */
+    void attachHistory(W_History *history);
+};
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <initializer_list>
+#include "w_signals.h"
+
+/**
+ * @file w_microprogram.h
+ * @brief Microprogram ROM of the standard W machine instruction list
+ *
+ * Every instruction starts with the common fetch step (czyt wys wei il), which loads
+ * the word at address A into register I and advances the counter L. The sequencer then
+ * decodes the instruction code of I and runs the execute steps of the instruction from
+ * this table. W_Machine::takt() executes the signals of a step phase by phase
+ * (Signals::Phase), whatever order they are listed in. Every instruction ends with A pointing at the
+ * next instruction, ready for the next fetch.
+ *
+ * DOD, ODE and PRZEP write the result straight into AK in this machine core, so the
+ * steps need no separate WEAK.
+ *
+ * Before execution every instruction is compiled into a CompiledInstruction: per step
+ * the mask of its signals and their execution order with the phases already resolved
+ * (Signals::Phase, bus drivers before bus receivers). Running a step is then a copy of
+ * a precompiled mask and order, with no conflict checks and no sorting.
+ *
+ * **Instruction list:**
+ * @li 0 STP - stop the program
+ * @li 1 DOD - AK + PAO[addr] → AK
+ * @li 2 ODE - AK - PAO[addr] → AK
+ * @li 3 POB - PAO[addr] → AK
+ * @li 4 ŁAD - AK → PAO[addr]
+ * @li 5 SOB - jump to addr
+ * @li 6 SOM - jump to addr if AK < 0
+ *
+ * @author Bartosz Faruga / MrRooby
+ * @date 2025
+ */
+
+namespace Microprogram {
+    constexpr uint8_t MAX_STEP_SIGNALS = 6;        ///< Most signals selected in one step
+    constexpr uint8_t MAX_EXECUTE_STEPS = 2;       ///< Most execute steps of one instruction
+
+    /**
+     * @enum Condition
+     * @brief Condition under which an execute step runs
+     */
+    enum class Condition : uint8_t {
+        ALWAYS,         ///< Step always runs
+        AK_NEGATIVE,    ///< Step runs when the sign bit of AK is set
+        AK_NOT_NEGATIVE ///< Step runs when the sign bit of AK is clear
+    };
+
+    /**
+     * @struct Step
+     * @brief Signals selected for one TAKT
+     */
+    struct Step {
+        uint8_t count = 0;                                      ///< Number of entries in signals
+        Signal signals[MAX_STEP_SIGNALS] = {};                  ///< Signals in selection order
+        Condition condition = Condition::ALWAYS;                ///< When the step runs
+    };
+
+    /**
+     * @struct Instruction
+     * @brief Execute steps of one instruction (after the fetch step)
+     */
+    struct Instruction {
+        const char *name = "";                                  ///< Mnemonic (ASCII, ŁAD is "LAD")
+        uint8_t stepCount = 0;                                  ///< Number of entries in steps (0 stops the machine)
+        Step steps[MAX_EXECUTE_STEPS] = {};                     ///< Execute steps
+    };
+
+    /** @brief Build a step from its signals in selection order */
+    constexpr Step step(std::initializer_list<Signal> signals, Condition condition = Condition::ALWAYS)
+    {
+        Step built;
+        for (Signal signal : signals) {
+            built.signals[built.count++] = signal;
+        }
+        built.condition = condition;
+        return built;
+    }
+
+    /** @brief Build an instruction from its execute steps */
+    constexpr Instruction instruction(const char *name, std::initializer_list<Step> steps)
+    {
+        Instruction built;
+        built.name = name;
+        for (const Step &executeStep : steps) {
+            built.steps[built.stepCount++] = executeStep;
+        }
+        return built;
+    }
+
+    /// Fetch step shared by every instruction
+    constexpr Step FETCH = step({Signal::CZYT, Signal::WYS, Signal::WEI, Signal::IL});
+
+    /// Execute steps of every instruction, indexed by the instruction code
+    constexpr Instruction INSTRUCTIONS[] = {
+        instruction("STP", {}),
+        instruction("DOD", {step({Signal::WYAD, Signal::WEA}),
+                            step({Signal::CZYT, Signal::WYS, Signal::WEJA, Signal::DOD, Signal::WYL, Signal::WEA})}),
+        instruction("ODE", {step({Signal::WYAD, Signal::WEA}),
+                            step({Signal::CZYT, Signal::WYS, Signal::WEJA, Signal::ODE, Signal::WYL, Signal::WEA})}),
+        instruction("POB", {step({Signal::WYAD, Signal::WEA}),
+                            step({Signal::CZYT, Signal::WYS, Signal::PRZEP, Signal::WYL, Signal::WEA})}),
+        instruction("LAD", {step({Signal::WYAD, Signal::WEA, Signal::WYAK, Signal::WES}),
+                            step({Signal::PISZ, Signal::WYL, Signal::WEA})}),
+        instruction("SOB", {step({Signal::WYAD, Signal::WEA, Signal::WEL})}),
+        instruction("SOM", {step({Signal::WYAD, Signal::WEA, Signal::WEL}, Condition::AK_NEGATIVE),
+                            step({Signal::WYL, Signal::WEA}, Condition::AK_NOT_NEGATIVE)}),
+    };
+
+    /**
+     * @struct CompiledStep
+     * @brief Step ready to be loaded into the machine
+     */
+    struct CompiledStep {
+        SignalMask signals = 0;                                 ///< Signals of the step
+        uint8_t count = 0;                                      ///< Number of entries in order
+        Signal order[MAX_STEP_SIGNALS] = {};                    ///< Signals in execution (phase) order
+        Condition condition = Condition::ALWAYS;                ///< When the step runs
+    };
+
+    /**
+     * @struct CompiledInstruction
+     * @brief Instruction ready to be run by the sequencer
+     */
+    struct CompiledInstruction {
+        const char *name = "";                                  ///< Mnemonic
+        uint8_t stepCount = 0;                                  ///< Number of entries in steps (0 stops the machine)
+        CompiledStep steps[MAX_EXECUTE_STEPS] = {};             ///< Execute steps
+    };
+
+    /**
+     * @brief Compile a step: build its signal mask and sort its signals by phase
+     *
+     * Signals of the same phase keep their order from the ROM.
+     */
+    constexpr CompiledStep compile(const Step &source)
+    {
+        CompiledStep compiled;
+        compiled.condition = source.condition;
+
+        for (uint8_t phase = 0; phase < static_cast<uint8_t>(Signals::Phase::COUNT); phase++) {
+            for (uint8_t n = 0; n < source.count; n++) {
+                Signal signal = source.signals[n];
+                if (static_cast<uint8_t>(Signals::phaseOf(signal)) == phase) {
+                    compiled.signals |= Signals::bit(signal);
+                    compiled.order[compiled.count++] = signal;
+                }
+            }
+        }
+        return compiled;
+    }
+
+    /** @brief Compile every step of an instruction */
+    constexpr CompiledInstruction compile(const Instruction &source)
+    {
+        CompiledInstruction compiled;
+        compiled.name = source.name;
+        compiled.stepCount = source.stepCount;
+
+        for (uint8_t n = 0; n < source.stepCount; n++) {
+            compiled.steps[n] = compile(source.steps[n]);
+        }
+        return compiled;
+    }
+
+    /// Fetch step, compiled
+    constexpr CompiledStep COMPILED_FETCH = compile(FETCH);
+
+    constexpr size_t INSTRUCTION_COUNT = sizeof(INSTRUCTIONS) / sizeof(INSTRUCTIONS[0]);  ///< Number of known instruction codes
+
+    /** @brief Check that the signals of a step can be selected together */
+    constexpr bool isConflictFree(const Step &step)
+    {
+        if (step.count > MAX_STEP_SIGNALS) {
+            return false;
+        }
+
+        SignalMask selected = 0;
+        for (uint8_t n = 0; n < step.count; n++) {
+            Signal signal = step.signals[n];
+            if (signal >= Signal::COUNT || (Signals::CONFLICTS[static_cast<uint8_t>(signal)] & selected)) {
+                return false;
+            }
+            selected |= Signals::bit(signal);
+        }
+        return true;
+    }
+
+    /** @brief Check that the signals of every step of an instruction can be selected together */
+    constexpr bool isConflictFree(const Instruction &source)
+    {
+        for (uint8_t n = 0; n < source.stepCount; n++) {
+            if (!isConflictFree(source.steps[n])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** @brief Check every step of the ROM for conflicts */
+    constexpr bool isRomValid()
+    {
+        if (!isConflictFree(FETCH)) {
+            return false;
+        }
+        for (const Instruction &source : INSTRUCTIONS) {
+            if (!isConflictFree(source)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static_assert(isRomValid(), "Microprogram: every step must select conflict-free signals");
+    static_assert(COMPILED_FETCH.order[0] == Signal::CZYT && COMPILED_FETCH.order[3] == Signal::IL,
+                  "Microprogram: the fetch step must read memory first and count last");
+}
@@ -0,0 +1,419 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "w_signals.h"
+
+/**
+ * @file w_protocol.h
+ * @brief Binary WebSocket protocol between the panel and the web app
+ *
+ * A compact alternative to the JSON messages. Every binary frame starts with an
+ * Opcode byte, multi-byte values are little-endian and every value is at most 16 bits
+ * wide. A register update is 4 bytes instead of a ~40-byte JSON document, and decoding
+ * it is a few byte reads instead of a JSON parse.
+ *
+ * **Negotiation:** a client starts in JSON. To switch, it sends a HELLO frame with the
+ * newest version it speaks; the panel answers with HELLO carrying the version both
+ * sides use (the lower of the two) and from then on sends binary frames to that client.
+ * Clients that never send HELLO (older web apps) keep using JSON.
+ *
+ * **Frames (client → panel):**
+ * @li HELLO    `[00][version]`
+ * @li FIELD    `[01][Field][value:16]` - one display value or line ("reg-update")
+ * @li PAO_ROWS `[02][first row][count]` + count × `[address:16][argument:16][value:16]`
+ * @li STATE    `[03][AK:16][A:16][S:16][L:16][I:16][signals:16][Lines]` + PAO_ROWS body
+ *              without the opcode - the whole panel ("mem-update")
+ * @li MEMORY   `[04][first address:16][count:16]` + count × `[word:16]` - bulk memory
+ *
+ * The JSON messages name the same targets with strings ("acc", "wyad", "busA", ...).
+ * fieldByName() maps them to a Field through a constexpr perfect hash, so both formats
+ * end in the same typed dispatch.
+ *
+ * **Frames (panel → client):**
+ * @li HELLO    `[00][version]`
+ * @li PANEL    `[10][encoder:8][count]` + count × `[Signal]` - panel input since the last
+ *              frame: signed encoder steps (DOWN positive) and the buttons pressed, in
+ *              order (Signal::NONE for TAKT). Version 1.
+ * @li DIFF     `[11][registers]` + one `[value:16]` per set bit + `[signals:16][Lines][count]`
+ *              + count × `[address:16][word:16]` + PANEL body without the opcode - the
+ *              machine state that changed since the last frame, and the panel input.
+ *              Version 2 and later, replaces PANEL.
+ *
+ * From version 2 the panel runs the machine itself: client frames are edits of the
+ * machine state, and the panel answers every change with a DIFF.
+ *
+ * @author Bartosz Faruga / MrRooby
+ * @date 2025
+ */
+
+namespace Protocol {
+    constexpr uint8_t VERSION = 2;                  ///< Newest protocol version of this firmware
+    constexpr uint8_t DIFF_VERSION = 2;             ///< First version receiving DIFF frames
+    constexpr uint8_t PAO_ROWS = 4;                 ///< Most PAO rows in one frame (rows of the panel)
+    constexpr uint8_t PANEL_BUTTONS = 8;            ///< Most button presses in one PANEL frame
+    constexpr uint8_t DIFF_REGISTERS = 6;           ///< Registers of a DIFF frame: L I AK A S JAML (W_Machine::Register order)
+    constexpr uint8_t DIFF_CELLS = 16;              ///< Most memory words in one DIFF frame
+
+    /**
+     * @enum Opcode
+     * @brief First byte of every binary frame
+     */
+    enum class Opcode : uint8_t {
+        HELLO    = 0x00,    ///< Protocol negotiation
+        FIELD    = 0x01,    ///< One display value or line
+        PAO_ROWS = 0x02,    ///< PAO rows of the panel
+        STATE    = 0x03,    ///< Whole panel
+        MEMORY   = 0x04,    ///< Range of memory words
+        PANEL    = 0x10,    ///< Panel input (buttons and encoder)
+        DIFF     = 0x11,    ///< Changed machine state and panel input
+    };
+
+    /**
+     * @enum Field
+     * @brief Target of a FIELD frame
+     *
+     * Values below Signal::COUNT are the signal lines, numbered like Signal.
+     */
+    enum class Field : uint8_t {
+        BUS_A = static_cast<uint8_t>(Signal::COUNT),    ///< Bus A line
+        BUS_S,              ///< Bus S line
+        STOP,               ///< STOP line
+        AK = 0x20,          ///< Accumulator display
+        A,                  ///< Address register display
+        S,                  ///< S register display
+        L,                  ///< Counter (L) display, "c" in JSON
+        I,                  ///< Instruction register display
+    };
+
+    constexpr uint8_t REGISTER_FIELDS = 5;          ///< Register displays in a STATE frame, AK to I in Field order
+
+    /** @brief Field of a signal line */
+    constexpr Field fieldOf(Signal signal) { return static_cast<Field>(signal); }
+
+    /** @brief Check whether a field is a signal line */
+    constexpr bool isSignal(Field field) { return static_cast<uint8_t>(field) < static_cast<uint8_t>(Signal::COUNT); }
+
+    /** @brief Check whether a field is a register display */
+    constexpr bool isRegister(Field field)
+    {
+        return field >= Field::AK && static_cast<uint8_t>(field) < static_cast<uint8_t>(Field::AK) + REGISTER_FIELDS;
+    }
+
+    /**
+     * @struct FieldName
+     * @brief Name of a Field in the JSON messages
+     */
+    struct FieldName {
+        const char *name;       ///< "field" value of a "reg-update", key in "mem-update"
+        Field field;            ///< Target
+    };
+
+    /// Every target addressed by name in the JSON messages
+    constexpr FieldName JSON_FIELDS[] = {
+        {"acc",   Field::AK},
+        {"a",     Field::A},
+        {"s",     Field::S},
+        {"c",     Field::L},
+        {"i",     Field::I},
+        {"il",    fieldOf(Signal::IL)},
+        {"wel",   fieldOf(Signal::WEL)},
+        {"wyl",   fieldOf(Signal::WYL)},
+        {"wyad",  fieldOf(Signal::WYAD)},
+        {"wei",   fieldOf(Signal::WEI)},
+        {"weak",  fieldOf(Signal::WEAK)},
+        {"dod",   fieldOf(Signal::DOD)},
+        {"ode",   fieldOf(Signal::ODE)},
+        {"przep", fieldOf(Signal::PRZEP)},
+        {"wyak",  fieldOf(Signal::WYAK)},
+        {"weja",  fieldOf(Signal::WEJA)},
+        {"wea",   fieldOf(Signal::WEA)},
+        {"czyt",  fieldOf(Signal::CZYT)},
+        {"pisz",  fieldOf(Signal::PISZ)},
+        {"wes",   fieldOf(Signal::WES)},
+        {"wys",   fieldOf(Signal::WYS)},
+        {"busA",  Field::BUS_A},
+        {"busS",  Field::BUS_S},
+        {"stop",  Field::STOP},
+    };
+
+    constexpr size_t JSON_FIELD_COUNT = sizeof(JSON_FIELDS) / sizeof(JSON_FIELDS[0]);   ///< Number of entries in JSON_FIELDS
+    constexpr uint32_t FIELD_HASH_SIZE = 64;                                            ///< Slots of the perfect hash (power of 2)
+
+    /** @brief FNV-1a hash of a name, varied by a seed */
+    constexpr uint32_t hashName(const char *name, uint32_t seed)
+    {
+        uint32_t hash = 2166136261u ^ seed;
+        while (*name) {
+            hash = (hash ^ static_cast<uint8_t>(*name++)) * 16777619u;
+        }
+        return hash ^ (hash >> 15);
+    }
+
+    /** @brief First seed for which every name of JSON_FIELDS gets its own slot, 0 if none */
+    constexpr uint32_t findFieldSeed()
+    {
+        for (uint32_t seed = 1; seed < 100000; seed++) {
+            uint64_t used = 0;
+            bool unique = true;
+            for (const FieldName &entry : JSON_FIELDS) {
+                uint64_t slot = 1ULL << (hashName(entry.name, seed) & (FIELD_HASH_SIZE - 1));
+                if (used & slot) {
+                    unique = false;
+                    break;
+                }
+                used |= slot;
+            }
+            if (unique) {
+                return seed;
+            }
+        }
+        return 0;
+    }
+
+    constexpr uint32_t FIELD_SEED = findFieldSeed();     ///< Seed of the perfect hash
+
+    static_assert(FIELD_HASH_SIZE <= 64, "Protocol: findFieldSeed() tracks slots in 64 bits");
+    static_assert(FIELD_SEED != 0, "Protocol: no collision-free seed for JSON_FIELDS");
+
+    /**
+     * @struct FieldTable
+     * @brief Perfect hash table of JSON_FIELDS, indexed by hashName(name, FIELD_SEED)
+     */
+    struct FieldTable {
+        const FieldName *slots[FIELD_HASH_SIZE] = {};   ///< Entry of JSON_FIELDS in each slot, or nullptr
+    };
+
+    /** @brief Build the perfect hash table */
+    constexpr FieldTable buildFieldTable()
+    {
+        FieldTable table;
+        for (const FieldName &entry : JSON_FIELDS) {
+            table.slots[hashName(entry.name, FIELD_SEED) & (FIELD_HASH_SIZE - 1)] = &entry;
+        }
+        return table;
+    }
+
+    constexpr FieldTable FIELD_TABLE = buildFieldTable();   ///< Perfect hash table of JSON_FIELDS
+
+    /**
+     * @brief Find the Field of a JSON name
+     *
+     * One hash and one string comparison, no allocation.
+     *
+     * @param name Name from a JSON message
+     * @param field Receives the target
+     *
+     * @return false for an unknown name
+     */
+    constexpr bool fieldByName(const char *name, Field &field)
+    {
+        const FieldName *entry = FIELD_TABLE.slots[hashName(name, FIELD_SEED) & (FIELD_HASH_SIZE - 1)];
+        if (entry && Signals::namesEqual(entry->name, name)) {
+            field = entry->field;
+            return true;
+        }
+        return false;
+    }
+
+    /// @name Bits of the lines byte of a STATE frame
+    /// @{
+    constexpr uint8_t LINE_BUS_A = 0x01;            ///< Bus A lit
+    constexpr uint8_t LINE_BUS_S = 0x02;            ///< Bus S lit
+    constexpr uint8_t LINE_STOP  = 0x04;            ///< STOP lit
+    /// @}
+
+    /**
+     * @struct PaORow
+     * @brief One row of the PAO display
+     */
+    struct PaORow {
+        uint16_t address = 0;   ///< Address shown in the row
+        uint16_t argument = 0;  ///< Instruction code shown in the row
+        uint16_t value = 0;     ///< Word shown in the row
+    };
+
+    /**
+     * @struct PaORows
+     * @brief Body of a PAO_ROWS frame
+     */
+    struct PaORows {
+        uint8_t first = 0;              ///< Panel row of rows[0]
+        uint8_t count = 0;              ///< Number of entries in rows
+        PaORow rows[PAO_ROWS];          ///< Rows from first on
+    };
+
+    /**
+     * @struct State
+     * @brief Body of a STATE frame
+     */
+    struct State {
+        uint16_t registers[REGISTER_FIELDS] = {};   ///< Register displays, AK A S L I
+        SignalMask signals = 0;                     ///< Lit signal lines
+        uint8_t lines = 0;                          ///< LINE_BUS_A, LINE_BUS_S, LINE_STOP
+        PaORows pao;                                ///< PAO rows
+    };
+
+    /**
+     * @struct Memory
+     * @brief Header of a MEMORY frame, the words stay in the frame
+     */
+    struct Memory {
+        uint16_t first = 0;                 ///< Address of the first word
+        uint16_t count = 0;                 ///< Number of words
+        const uint8_t *words = nullptr;     ///< count little-endian 16-bit words
+
+        /** @brief Word n of the frame */
+        uint16_t word(uint16_t n) const { return words[2 * n] | (words[2 * n + 1] << 8); }
+    };
+
+    /**
+     * @struct Panel
+     * @brief Body of a PANEL frame
+     */
+    struct Panel {
+        int8_t encoder = 0;                         ///< Encoder steps, DOWN positive
+        uint8_t count = 0;                          ///< Number of entries in buttons
+        Signal buttons[PANEL_BUTTONS] = {};         ///< Buttons pressed, oldest first
+
+        /** @brief Check whether there is anything to send */
+        bool isEmpty() const { return count == 0 && encoder == 0; }
+
+        /** @brief Append the input of a later frame, presses past PANEL_BUTTONS are dropped */
+        void merge(const Panel &later)
+        {
+            for (uint8_t n = 0; n < later.count && count < PANEL_BUTTONS; n++) {
+                buttons[count++] = later.buttons[n];
+            }
+            int steps = encoder + later.encoder;
+            encoder = static_cast<int8_t>(steps > INT8_MAX ? INT8_MAX : (steps < INT8_MIN ? INT8_MIN : steps));
+        }
+    };
+
+    /**
+     * @struct Cell
+     * @brief One memory word of a DIFF frame
+     */
+    struct Cell {
+        uint16_t address = 0;   ///< Memory address
+        uint16_t word = 0;      ///< Word stored at address
+    };
+
+    /**
+     * @struct Diff
+     * @brief Body of a DIFF frame
+     */
+    struct Diff {
+        uint8_t registers = 0;                      ///< Bit n set when values[n] is sent
+        uint16_t values[DIFF_REGISTERS] = {};       ///< Register values, L I AK A S JAML
+        SignalMask signals = 0;                     ///< Signals selected for the next TAKT
+        uint8_t lines = 0;                          ///< LINE_BUS_A, LINE_BUS_S driven since the last frame, LINE_STOP lit
+        uint8_t count = 0;                          ///< Number of entries in cells
+        Cell cells[DIFF_CELLS];                     ///< Memory words that changed
+        Panel panel;                                ///< Panel input since the last frame
+    };
+
+    constexpr size_t PANEL_SIZE = 3 + PANEL_BUTTONS;                                     ///< Largest PANEL frame
+    constexpr size_t DIFF_SIZE = 2 + 2 * DIFF_REGISTERS + 2 + 1 + 1 + 4 * DIFF_CELLS + PANEL_SIZE - 1;   ///< Largest DIFF frame
+
+    /**
+     * @class Reader
+     * @brief Bounds-checked reader of a received frame
+     *
+     * Reading past the end returns 0 and clears isOk(), so a decoder checks once at the end.
+     */
+    class Reader {
+    private:
+        const uint8_t *data;
+        size_t size;
+        size_t position = 0;
+        bool ok = true;
+
+    public:
+        Reader(const uint8_t *data, size_t size) : data(data), size(size) {}
+
+        uint8_t u8()
+        {
+            if (position + 1 > size) { ok = false; return 0; }
+            return data[position++];
+        }
+
+        uint16_t u16()
+        {
+            if (position + 2 > size) { ok = false; return 0; }
+            uint16_t value = data[position] | (data[position + 1] << 8);
+            position += 2;
+            return value;
+        }
+
+        /** @brief Skip count bytes and return a pointer to them, nullptr past the end */
+        const uint8_t* bytes(size_t count)
+        {
+            if (position + count > size) { ok = false; return nullptr; }
+            const uint8_t *start = data + position;
+            position += count;
+            return start;
+        }
+
+        /** @brief Mark the frame as malformed */
+        void fail() { ok = false; }
+
+        bool isOk() const { return ok; }
+        size_t remaining() const { return size - position; }
+    };
+
+    /**
+     * @class Writer
+     * @brief Bounds-checked writer of a frame into a caller buffer
+     */
+    class Writer {
+    private:
+        uint8_t *data;
+        size_t size;
+        size_t position = 0;
+        bool ok = true;
+
+    public:
+        Writer(uint8_t *data, size_t size) : data(data), size(size) {}
+
+        void u8(uint8_t value)
+        {
+            if (position + 1 > size) { ok = false; return; }
+            data[position++] = value;
+        }
+
+        void u16(uint16_t value)
+        {
+            if (position + 2 > size) { ok = false; return; }
+            data[position++] = value & 0xFF;
+            data[position++] = value >> 8;
+        }
+
+        bool isOk() const { return ok; }
+
+        /** @brief Length of the frame, 0 when it did not fit */
+        size_t length() const { return ok ? position : 0; }
+    };
+
+    /** @brief Opcode of a frame, or false for an empty frame */
+    bool peekOpcode(const uint8_t *data, size_t size, Opcode &opcode);
+
+    /// @name Decoders
+    /// Decode the body of a frame whose opcode was read already. Return false for a
+    /// truncated or malformed frame.
+    /// @{
+    bool decodeHello(Reader &reader, uint8_t &version);
+    bool decodeField(Reader &reader, Field &field, uint16_t &value);
+    bool decodePaORows(Reader &reader, PaORows &rows);
+    bool decodeState(Reader &reader, State &state);
+    bool decodeMemory(Reader &reader, Memory &memory);
+    /// @}
+
+    /// @name Encoders
+    /// Write a whole frame into the buffer. Return its length, 0 when it does not fit.
+    /// @{
+    size_t encodeHello(uint8_t *buffer, size_t size, uint8_t version);
+    size_t encodePanel(uint8_t *buffer, size_t size, const Panel &panel);
+    size_t encodeDiff(uint8_t *buffer, size_t size, const Diff &diff);
+    /// @}
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <stdint.h>
+#include "w_machine.h"
+#include "w_microprogram.h"
+
+/**
+ * @file w_sequencer.h
+ * @brief Microprogram sequencer running whole W machine programs
+ *
+ * Drives a W_Machine from the Microprogram ROM: on every clock tick it executes the
+ * signals selected for the current step with W_Machine::takt() and selects the signals
+ * of the next step. The selected signals stay on the panel between ticks, so at a slow
+ * clock the student sees which step runs next, exactly as after selecting it by hand.
+ *
+ * The instructions are compiled once, when the sequencer is constructed, into a table
+ * indexed by the instruction code (Microprogram::CompiledInstruction). A step loads a
+ * precompiled signal mask and phase order into the machine. setInstruction() replaces
+ * one entry of the table, so a user-defined instruction list recompiles only the
+ * instructions it changes.
+ *
+ * The clock is a table of periods from 0.5 Hz up to "as fast as possible" (one step per
+ * call of update()). Past that is the turbo speed, where the caller runs bursts of steps
+ * with runBurst() and redraws the panel only between bursts. The sequencer has no
+ * Arduino dependency; the caller passes the current time.
+ *
+ * @author Bartosz Faruga / MrRooby
+ * @date 2025
+ */
+class W_Sequencer
+{
+public:
+    /**
+     * @struct ClockSpeed
+     * @brief One entry of the clock speed table
+     */
+    struct ClockSpeed {
+        uint32_t periodMicros;  ///< Time between steps, 0 runs a step on every update()
+        const char *label;      ///< Speed shown to the user
+    };
+
+    /// Selectable clock speeds, slowest first
+    static constexpr ClockSpeed SPEEDS[] = {
+        {2000000, "0.5 Hz"},
+        {1000000, "1 Hz"},
+        { 500000, "2 Hz"},
+        { 200000, "5 Hz"},
+        { 100000, "10 Hz"},
+        {  50000, "20 Hz"},
+        {  20000, "50 Hz"},
+        {  10000, "100 Hz"},
+        {   2000, "500 Hz"},
+        {   1000, "1 kHz"},
+        {      0, "MAX"},
+        {      0, "TURBO"},
+    };
+
+    static constexpr uint8_t SPEED_COUNT = sizeof(SPEEDS) / sizeof(SPEEDS[0]);  ///< Number of entries in SPEEDS
+    static constexpr uint8_t TURBO_SPEED = SPEED_COUNT - 1;                       ///< Index of the turbo speed in SPEEDS
+
+    static_assert(SPEEDS[TURBO_SPEED].periodMicros == 0, "W_Sequencer: the turbo speed has no clock period");
+
+private:
+    static constexpr uint8_t FETCH_STEP = 0xFF;              ///< Value of step while the fetch step is selected
+    static constexpr uint32_t OPCODE_COUNT = 1UL << W_Machine::GEOMETRY.opcodeBits;  ///< Number of instruction codes
+
+    W_Machine &machine;                                      ///< Machine driven by the sequencer
+
+    /// Compiled instructions, indexed by the instruction code (unused codes stop the machine)
+    Microprogram::CompiledInstruction instructions[OPCODE_COUNT];
+
+    const Microprogram::CompiledInstruction *instruction = nullptr;  ///< Instruction being executed (nullptr during fetch)
+    uint8_t step = FETCH_STEP;                               ///< Execute step selected in the machine
+
+    bool running = false;                                    ///< Set while the clock runs
+    bool halted = false;                                     ///< Set after STP (or an unknown instruction) executed
+    bool stepSelected = false;                               ///< Set when the current step is selected in the machine
+
+    uint8_t speed = 1;                                       ///< Index into SPEEDS
+    uint32_t lastTickMicros = 0;                             ///< Time of the last step
+
+    /** @brief Check whether an execute step runs for the current AK */
+    bool isStepEnabled(const Microprogram::CompiledStep &executeStep) const;
+
+    /**
+     * @brief Advance to the next step that runs
+     *
+     * Decodes register I after the fetch step and skips execute steps whose condition
+     * fails. Halts on STP and unknown instruction codes.
+     */
+    void advance();
+
+    /** @brief Load the compiled signals of the current step into the machine */
+    void selectStep();
+
+public:
+    /**
+     * @brief Construct a stopped sequencer positioned before a fetch
+     *
+     * Compiles the standard instruction list of the Microprogram ROM.
+     *
+     * @param machine Machine to drive, must outlive the sequencer
+     */
+    explicit W_Sequencer(W_Machine &machine);
+
+    /**
+     * @brief Compile an instruction into the table, replacing the previous one
+     *
+     * Only this entry is recompiled. Must not be called while the clock runs.
+     *
+     * @param opcode Instruction code
+     * @param source Instruction to compile
+     *
+     * @return false if the code is out of range or a step selects conflicting signals
+     */
+    bool setInstruction(uint32_t opcode, const Microprogram::Instruction &source);
+
+    /**
+     * @brief Start (or resume) the clock
+     *
+     * After a halt the program continues with a fetch from address A. Signals selected
+     * by hand are replaced by the signals of the current step.
+     *
+     * @param nowMicros Current time in microseconds
+     */
+    void start(uint32_t nowMicros);
+
+    /**
+     * @brief Stop the clock and deselect the signals of the pending step
+     *
+     * The position in the microprogram is kept, so start() resumes with the same step.
+     */
+    void stop();
+
+    /**
+     * @brief Forget the position in the microprogram
+     *
+     * Used after the machine state was replaced (e.g. by stepping back through the
+     * history): the next start() begins with a fetch from address A. Must not be called
+     * while the clock runs.
+     */
+    void rewind();
+
+    /**
+     * @brief Execute the selected step and select the next one
+     *
+     * @return false when the machine halted
+     */
+    bool tick();
+
+    /**
+     * @brief Run the steps that are due
+     *
+     * Does nothing at the turbo speed, see runBurst().
+     *
+     * @param nowMicros Current time in microseconds
+     */
+    void update(uint32_t nowMicros);
+
+    /**
+     * @brief Run steps back to back while the clock runs
+     *
+     * Used by the turbo speed. The machine keeps collecting its change notifications,
+     * so the front end can draw one snapshot after any number of bursts.
+     *
+     * @param maxSteps Most steps to run
+     *
+     * @return Number of steps executed (fewer than maxSteps when the machine halted)
+     */
+    uint32_t runBurst(uint32_t maxSteps);
+
+    /** @brief Check whether the clock runs */
+    bool isRunning() const;
+
+    /** @brief Check whether STP stopped the program */
+    bool isHalted() const;
+
+    /**
+     * @brief Select a clock speed
+     *
+     * @param index Index into SPEEDS, clamped to the table
+     */
+    void setSpeed(uint8_t index);
+
+    /** @brief Index of the selected clock speed in SPEEDS */
+    uint8_t getSpeed() const;
+
+    /** @brief Check whether the turbo speed is selected */
+    bool isTurbo() const;
+
+    /** @brief Mnemonic of the instruction being executed, or "" during the fetch */
+    const char* getInstructionName() const;
+};
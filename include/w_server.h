@@ -12,6 +12,10 @@
 #include "display_manager.h"
 #include "human_interface.h"
 #include "file_system.h"
+#include "w_protocol.h"
+#include "json_arena.h"
+#include "w_local.h"
+#include <freertos/semphr.h>
 
 /** @brief Maximum number of simultaneous WiFi client connections */
 #define MAX_CLIENTS 2
@@ -19,30 +23,57 @@
 /** @brief WiFi channel for Access Point (2.4GHz channel 6) */
 #define WIFI_CHANNEL 6
 
+/**
+ * @brief Largest WebSocket message reassembled from several frames or TCP segments
+ * 
+ * One buffer of this size is kept per WebSocket session. Override in platformio.ini,
+ * e.g. `-DW_WS_MESSAGE_MAX=16384` for memory uploads of a 4096-word machine.
+ */
+#ifndef W_WS_MESSAGE_MAX
+#define W_WS_MESSAGE_MAX 4096
+#endif
+
+/**
+ * @brief Most frames sent to one WebSocket client per second
+ * 
+ * Panel input is collected between two frames and sent as one.
+ */
+#ifndef W_WS_PUBLISH_HZ
+#define W_WS_PUBLISH_HZ 30
+#endif
+
 /**
  * @file w_server.h
  * @brief Web server implementation for ESP32 with WebSocket and captive portal support
  * 
  * Implements a WiFi Access Point with WebSocket communication for remote machine control.
- * Provides real-time display updates, button event handling, and color configuration management.
+ * The machine runs on the panel: W_Server hosts the same W_Local engine as the local
+ * mode, so a button press executes and lights up within one loop, and the web clients
+ * are sent what changed. Client messages are edits of the machine state.
  * 
  * **Features:**
  * @li WiFi Access Point creation with captive portal
  * @li WebSocket server for real-time bidirectional communication
  * @li DNS server for client redirect to portal
  * @li Static web file serving from LittleFS
- * @li Real-time display synchronization
- * @li Button press event broadcasting
+ * @li Machine core running on the panel (W_Local), with the same controls as the local mode
+ * @li State diffs and button presses published to every client
  * @li Loading animation when idle
  * @li LED status indicators
  * @li Color configuration persistence
  * 
  * **WebSocket Message Types:**
- * @li "reg-update" - Partial display/signal updates (single field)
- * @li "mem-update" - Full machine state update (all registers)
+ * @li "reg-update" - Edit of one register, signal or the PAO rows
+ * @li "mem-update" - Edit of all registers and the PAO rows
+ * @li "signal-toggle" - Selection or deselection of one signal
  * @li "color-update" - Display element color configuration
  * @li "ping" - Connection keep-alive probe
  * 
+ * A client that sends a binary HELLO frame switches to the compact binary protocol
+ * (w_protocol.h); clients that do not keep using the JSON messages above.
+ * The bundled web app reads only "button_press" and "signal-toggle" from the panel,
+ * so the registers and memory it shows are not updated by the machine.
+ * 
  * **Network Configuration:**
  * @li IP Address: 192.168.4.1
  * @li Subnet Mask: 255.255.255.0
@@ -78,11 +109,97 @@ private:
     DisplayManager *dispMan    = nullptr;  ///< Pointer to display manager for hardware control
     HumanInterface *humInter   = nullptr;  ///< Pointer to human interface for button input
     FileSystem     *fileSystem = nullptr;  ///< Pointer to file system for configuration storage
+
+    W_Local local;                         ///< Machine core with the panel controls of the local mode, used by the loop only
+
+    /**
+     * @struct MachineEdits
+     * @brief Client edits waiting for the loop to apply them to the machine
+     * 
+     * Edits of one target coalesce: the last value of a register, memory word or signal wins.
+     */
+    struct MachineEdits {
+        uint8_t registers = 0;                              ///< Bit n set when values[n] is to be written
+        uint16_t values[W_Machine::REGISTER_COUNT] = {};    ///< Register values, indexed by W_Machine::Register
+        SignalMask select = 0;                              ///< Signals to select
+        SignalMask deselect = 0;                            ///< Signals to deselect
+        std::bitset<W_Machine::MEMORY_SIZE> memory;         ///< Bit n set when words[n] is to be stored
+        uint16_t words[W_Machine::MEMORY_SIZE] = {};        ///< Memory words, indexed by address
+
+        /** @brief Check whether there is anything to apply */
+        bool any() const { return registers || select || deselect || memory.any(); }
+    };
+
+    MachineEdits edits;                    ///< Edits received since the last loop
+
+    /// Guards sessions and edits between the loop and the AsyncTCP task running onEvent().
+    /// Held only to copy state in or out, never while running the machine or calling a client.
+    SemaphoreHandle_t machineMutex = nullptr;
+
+    /// Held by publishUpdates() while it calls clients; WS_EVT_DISCONNECT waits for it,
+    /// so a client is not freed while it is used
+    SemaphoreHandle_t clientMutex = nullptr;
+
+    static constexpr unsigned long IP_SHOW_MILLIS = 3000;   ///< Time the IP address stays on the panel after the first client connects
+    bool showingIP = false;                ///< The IP address is on the panel instead of the machine
+    unsigned long ipShownTime = 0;         ///< When the IP address was drawn
     
-    char* lastSignal = nullptr;            ///< Tracks last button signal to detect changes
+    const PanelButton* lastSignal = nullptr;            ///< Tracks last button signal to detect changes
+
+    static constexpr unsigned long PUBLISH_PERIOD_MILLIS = 1000 / W_WS_PUBLISH_HZ;  ///< Time between two published frames
+    static constexpr unsigned long STATS_REPORT_MILLIS = 5000;                      ///< Interval of the queue statistics report
+    static constexpr size_t UPDATE_JSON_SIZE = 768;                                 ///< Buffer of the JSON form of a DIFF frame
+
+    Protocol::Panel outbox;                ///< Panel input collected since the last publish, merged into every session
+    unsigned long lastPublishTime = 0;     ///< Time of the last published frame
+    unsigned long lastStatsTime = 0;       ///< Time of the last statistics report
     bool loading = true;                   ///< Flag indicating loading animation state
     int lastClientCount = 0;               ///< Tracks previous client count for state change detection
 
+    /**
+     * @struct ClientSession
+     * @brief Per-client state of one WebSocket connection
+     */
+    struct ClientSession {
+        uint32_t id = 0;                   ///< AsyncWebSocketClient id, 0 for a free entry
+        uint8_t version = 0;               ///< Negotiated binary protocol version, 0 for JSON
+        MachineChanges pending;            ///< Machine state the client has not been sent yet
+        Protocol::Panel panel;             ///< Panel input the client has not been sent yet
+        SignalMask shownSignals = 0;       ///< Signals a JSON client was last sent as selected
+
+        uint32_t sent = 0;                 ///< Frames published to the client
+        uint32_t dropped = 0;              ///< Frames skipped because the client's send queue was full
+        uint32_t reportedDropped = 0;      ///< dropped at the last statistics report
+        uint16_t queueDepth = 0;           ///< Messages in the client's send queue at the last publish
+        uint16_t maxQueueDepth = 0;        ///< Deepest send queue seen
+
+        uint8_t opcode = 0;                ///< WS_TEXT or WS_BINARY of the message being reassembled
+        bool overflowed = false;           ///< The message being reassembled exceeds W_WS_MESSAGE_MAX
+        size_t received = 0;               ///< Bytes of the message reassembled so far
+        uint8_t message[W_WS_MESSAGE_MAX]; ///< Reassembly buffer
+    };
+
+    /// Most WebSocket connections, a reloading page briefly holds two per station
+    static constexpr uint8_t MAX_SESSIONS = MAX_CLIENTS * 2;
+
+    ClientSession sessions[MAX_SESSIONS];  ///< Connected clients
+
+    static constexpr size_t JSON_ARENA_SIZE = 2048;          ///< Memory for the JSON document of one message
+    JsonArena<JSON_ARENA_SIZE> jsonArena;                    ///< Allocator of the JSON documents, reset per message
+
+    /** @brief Session of a client, or nullptr */
+    ClientSession* sessionOf(uint32_t id);
+
+    /**
+     * @brief Start a session for a new client
+     * 
+     * @return false when every session is taken; the caller closes the client
+     */
+    bool openSession(uint32_t id);
+
+    /** @brief End the session of a disconnected client */
+    void closeSession(uint32_t id);
+
     /**
      * @brief Initialize all server components
      * 
@@ -157,53 +274,153 @@ private:
     void createWebSocketServer();
 
     /**
-     * @brief Handle incoming WebSocket message frame
+     * @brief Handle one WebSocket data event
+     * 
+     * A message that arrives in one event (the common case) is dispatched straight
+     * from the event data. A message split into several WebSocket frames, or one frame
+     * split into several TCP segments, is appended to the reassembly buffer of the
+     * client's session and dispatched once its last byte arrived. Messages longer than
+     * W_WS_MESSAGE_MAX are dropped with one error message.
+     * 
+     * Runs without machineMutex: the reassembly fields are only used by the AsyncTCP
+     * task, and the dispatched handlers lock around their own edits.
+     * 
+     * @param client Client the data came from
+     * @param arg Pointer to AwsFrameInfo structure containing frame metadata
+     * @param data Data bytes of this event
+     * @param len Number of data bytes
+     * 
+     * @see dispatchMessage()
+     */
+    void handleWebSocketMessage(AsyncWebSocketClient *client, void *arg, uint8_t *data, size_t len);
+
+    /**
+     * @brief Route one complete WebSocket message
+     * 
+     * @li WS_BINARY → handleBinaryMessage()
+     * @li WS_TEXT → handleJsonMessage()
+     * 
+     * @param client Client the message came from
+     * @param opcode WebSocket opcode of the message
+     * @param data Message bytes
+     * @param len Message length in bytes
+     */
+    void dispatchMessage(AsyncWebSocketClient *client, uint8_t opcode, const uint8_t *data, size_t len);
+
+    /**
+     * @brief Parse a JSON message and route it by its type
      * 
-     * Parses the raw WebSocket frame data and deserializes JSON content.
      * Determines message type and routes to appropriate handler:
      * @li "reg-update" → processPartialWebSocketData()
      * @li "mem-update" → processFullWebSocketData()
+     * @li "signal-toggle" → stageField() of the named signal
      * @li "color-update" → updateColors()
      * @li "ping" → Connection verification (no action)
      * 
-     * @param arg Pointer to AwsFrameInfo structure containing frame metadata
-     * @param data Raw message data bytes
-     * @param len Message data length in bytes
+     * @param data Message text, not 0-terminated
+     * @param len Message length in bytes
      * 
      * @note Validates JSON deserialization and logs errors to serial console
      */
-    void handleWebSocketMessage(void *arg, uint8_t *data, size_t len);
+    void handleJsonMessage(const uint8_t *data, size_t len);
+
+    /**
+     * @brief Decode one binary protocol frame and stage its edits
+     * 
+     * @li HELLO → Negotiate the protocol version and answer with HELLO
+     * @li FIELD → stageField()
+     * @li PAO_ROWS → stagePaORows()
+     * @li STATE → stageState()
+     * @li MEMORY → stageMemory()
+     * 
+     * Malformed frames are dropped.
+     * 
+     * @param client Client the frame came from
+     * @param data Frame bytes
+     * @param len Frame length in bytes
+     */
+    void handleBinaryMessage(AsyncWebSocketClient *client, const uint8_t *data, size_t len);
+
+    /// Register edited by each register Field, AK A S L I
+    static constexpr W_Machine::Register FIELD_REGISTERS[Protocol::REGISTER_FIELDS] = {
+        W_Machine::regAK, W_Machine::regA, W_Machine::regS, W_Machine::regL, W_Machine::regI
+    };
+
+    /// @name Client Edits
+    /// Run on the AsyncTCP task with machineMutex held. They only record the edit in
+    /// edits; the loop applies it with applyEdits().
+    /// @{
+
+    /** @brief Select or deselect a signal */
+    void stageSignal(Signal signal, bool active);
+
+    /** @brief Write a register */
+    void stageRegister(W_Machine::Register reg, uint16_t value);
+
+    /** @brief Store a memory word (addresses wrap around the memory size) */
+    void stageWord(uint32_t address, uint16_t word);
+
+    /**
+     * @brief Edit one register or select/deselect one signal
+     * 
+     * Bus and STOP lines are driven by the machine, edits of them are ignored.
+     * 
+     * @param field Register or signal
+     * @param value Register value, or non-zero to select a signal
+     */
+    void stageField(Protocol::Field field, uint16_t value);
+
+    /** @brief Store the words of PAO rows received from a client */
+    void stagePaORows(const Protocol::PaORows &rows);
+
+    /** @brief Edit the machine to a whole panel state received from a client */
+    void stageState(const Protocol::State &state);
+
+    /** @brief Store the words of a MEMORY frame */
+    void stageMemory(const Protocol::Memory &memory);
+
+    /// @}
+
+    /**
+     * @brief Apply the staged client edits to the machine through W_Local
+     * 
+     * Registers first, then signals (deselected before the new ones are selected, so
+     * replacing a signal with a conflicting one is not rejected), then memory words.
+     * Runs on the loop with machineMutex held.
+     */
+    void applyEdits();
 
     /**
      * @brief Process partial WebSocket updates for individual display elements
      * 
-     * Handles "reg-update" messages that update single display values or signal lines.
-     * Supports the following field types:
+     * Handles "reg-update" messages that edit one register or signal.
+     * The "field" name is routed through Protocol::fieldByName() (a constexpr perfect
+     * hash) to stageField(), the same target the binary FIELD frame uses. Nothing is
+     * copied or logged on this path.
      * 
-     * **Display Values (integer):**
-     * @li "acc", "a", "s", "c", "i" - Three-digit displays
-     * @li "addrs", "args", "vals" - PAO display array updates
+     * **Registers (integer):**
+     * @li "acc", "a", "s", "c", "i"
+     * @li "addrs", "args", "vals" - PAO rows, the words of "vals" are stored
      * 
-     * **Signal Lines (boolean):**
+     * **Signals (boolean):**
      * @li "il", "wel", "wyl", "wyad", "wei", "weak", "dod", "ode"
      * @li "przep", "weja", "wyak", "wea", "czyt", "pisz", "wes", "wys"
-     * @li "busA", "busS", "stop"
+     * @li "busA", "busS", "stop" - Ignored, the machine drives these lines
      * 
-     * @param doc StaticJsonDocument containing the update with keys:
+     * @param doc JSON document containing the update with keys:
      *            - "field": Target display/signal name
      *            - "value": New value (int for displays, bool for signals)
      *            - "addrs"/"args"/"vals": Arrays for PAO updates
      * 
-     * @note Logs all updates to serial console
      * @see processFullWebSocketData()
      */
-    void processPartialWebSocketData(StaticJsonDocument<512> doc);
+    void processPartialWebSocketData(const JsonDocument &doc);
 
     /**
      * @brief Process full WebSocket updates for entire machine state
      * 
      * Handles "mem-update" messages containing a complete snapshot of machine state.
-     * Updates all registers and displays from the provided JSON document.
+     * Edits all registers and the PAO rows to the values of the provided JSON document.
      * 
      * **Fields in update:**
      * @li "data.acc" - Accumulator value (0-999)
@@ -215,41 +432,121 @@ private:
      * @li "data.args[]" - PAO argument array (4 entries)
      * @li "data.vals[]" - PAO value array (4 entries)
      * 
-     * @param doc StaticJsonDocument with nested "data" object containing all state
+     * @param doc JSON document with nested "data" object containing all state
      * 
      * @note Used for synchronizing complete state after client connection
      * @see processPartialWebSocketData()
      */
-    void processFullWebSocketData(StaticJsonDocument<512> doc);
+    void processFullWebSocketData(const JsonDocument &doc);
+
+    /**
+     * @brief Read the "addrs", "args" and "vals" arrays of a JSON message
+     * 
+     * @param source Object holding the three arrays
+     * @param rows Receives all PAO rows
+     * 
+     * @return false when an array is missing
+     */
+    bool readPaORows(JsonObjectConst source, Protocol::PaORows &rows);
+
+    /**
+     * @brief Run the machine for one loop and queue its changes for every client
+     * 
+     * Applies the staged client edits, calls W_Local::runLocal() (panel input,
+     * auto-clock, drawing) without holding any lock, then adds the drawn changes to the
+     * pending set of each session.
+     * While the IP address is shown, the machine waits until IP_SHOW_MILLIS passed or a
+     * button is pressed, then draws the whole panel.
+     */
+    void runMachine();
 
     /**
-     * @brief Send button press event to all connected WebSocket clients
+     * @brief Send the state changes and panel input to every client, at most W_WS_PUBLISH_HZ times a second
      * 
-     * Constructs a JSON message with button press information and broadcasts it
-     * to all currently connected WebSocket clients. Enables remote display of
-     * local button presses when hybrid control is used.
+     * Every client gets one frame with the machine state it was not sent yet (its
+     * pending changes, read from the machine at sending time) and the buttons pressed
+     * since the last frame: binary v2 clients a DIFF frame, v1 clients a PANEL frame,
+     * JSON clients the JSON form of the DIFF frame. A client whose send queue is full
+     * skips the frame instead of queueing it behind stale ones; its changes stay pending,
+     * so the next frame carries the newest values. Skips are counted in the session.
      * 
-     * **Message format:**
+     * Button presses are never superseded, so they are not dropped with a skipped frame:
+     * the outbox is merged into the panel backlog of every session and emptied, and a
+     * session's backlog is sent with its next frame. A client that skips frames long
+     * enough to miss more than Protocol::PANEL_BUTTONS presses keeps the oldest ones.
+     * 
+     * The changes of a session are taken under machineMutex and the frame is sent after
+     * it is released; clientMutex keeps the clients alive while they are called.
+     * 
+     * **JSON message format:**
      * ```json
      * {
      *   "type": "button_press",
-     *   "buttonName": "IL"
+     *   "buttonName": "IL",
+     *   "buttons": ["IL", "WEL"],
+     *   "state": {"acc": 42, "c": 3, "jaml": 0, "signals": ["il", "wel"],
+     *             "busA": true, "stop": false, "mem": [[0, 37], [1, 5]]}
      * }
      * ```
+     * "buttonName" is the first button pressed since the last frame, "buttons" lists all
+     * of them. "state" holds the registers and memory words that changed, the selected
+     * signals, the buses driven since the last frame and the STOP line. Changes without
+     * a button press are sent as `{"type": "state", "state": {...}}`.
+     * 
+     * The bundled web app ignores "state"; it is followed by one
+     * `{"type": "signal-toggle", "signal": "wel", "state": true}` per signal selected or
+     * deselected since the client's last frame, which the app applies after its own
+     * toggle of "buttonName".
+     * 
+     * @see runMachine()
+     * @see collectPanelInput()
+     */
+    void publishUpdates();
+
+    /**
+     * @brief Fill a DIFF frame with the pending changes of a session
+     * 
+     * Takes at most Protocol::DIFF_CELLS memory words, the rest stays pending for the
+     * next frame. The panel backlog is taken whole. Call with machineMutex held.
      * 
-     * @param buttonNum Pointer to button name string (e.g., "IL", "WEL", "TAKT")
+     * @param session Session whose pending changes are taken
+     * @param diff Receives the changes and the panel backlog of the session
+     */
+    void takeDiff(ClientSession &session, Protocol::Diff &diff);
+
+    /**
+     * @brief Format a DIFF frame as a JSON message
+     * 
+     * @param diff Changes and panel input
+     * @param buffer Destination, UPDATE_JSON_SIZE bytes fit every frame
+     * @param size Size of buffer
+     * 
+     * @return Length of the message
+     */
+    size_t formatUpdateJson(const Protocol::Diff &diff, char *buffer, size_t size) const;
+
+    /**
+     * @brief Send a JSON client one "signal-toggle" message per changed signal
+     * 
+     * @param client Client to send to
+     * @param toggled Signals selected or deselected since the client's last frame
+     * @param selected Signals selected now
+     */
+    void sendSignalToggles(AsyncWebSocketClient *client, SignalMask toggled, SignalMask selected);
+
+    /**
+     * @brief Print the send queue statistics of clients that dropped frames
      * 
-     * @note Called when button is pressed on the local machine
-     * @see sendSignalValue()
+     * Runs every STATS_REPORT_MILLIS.
      */
-    void sendDataToClient(char *buttonNum);
+    void reportClientStats();
 
     /**
      * @brief WebSocket event callback handler
      * 
      * Routes WebSocket events to appropriate handlers:
-     * @li WS_EVT_CONNECT - Log client connection with IP and ID
-     * @li WS_EVT_DISCONNECT - Log client disconnection
+     * @li WS_EVT_CONNECT - Log client connection with IP and ID, open its session
+     * @li WS_EVT_DISCONNECT - Log client disconnection, close its session
      * @li WS_EVT_DATA - Route to handleWebSocketMessage()
      * @li WS_EVT_PONG - PONG response (reserved for future use)
      * @li WS_EVT_ERROR - Error handling (reserved for future use)
@@ -287,16 +584,17 @@ private:
     void runningServerLED();
 
     /**
-     * @brief Broadcast button press to connected WebSocket clients
+     * @brief Collect panel input for the next published frame
      * 
-     * Monitors button input from HumanInterface and sends button press events
-     * to all connected clients when a new button press is detected.
-     * Uses lastSignal to track state changes and avoid duplicate sends.
+     * Appends every new button press the machine handled to the outbox (presses past
+     * Protocol::PANEL_BUTTONS in one frame are dropped). Uses lastSignal to detect new
+     * presses. The encoder belongs to the machine (insert mode, PAO scrolling, history),
+     * its effect reaches the clients as state changes.
      * 
      * @note Called during runServer() loop
-     * @see sendDataToClient()
+     * @see publishUpdates()
      */
-    void sendSignalValue();
+    void collectPanelInput();
     
     /**
      * @brief Manage loading animation based on client connection state
@@ -322,14 +620,14 @@ private:
      * 
      * All colors are stored as hex strings (#RRGGBB format) in the configuration.
      * 
-     * @param doc StaticJsonDocument with structure:
+     * @param doc JSON document with structure:
      *            - "data.colorType": Type of element to update
      *            - "data.hex": Hex color string (e.g., "#FF0000")
      * 
      * @note Persists color changes to LittleFS for retention after reboot
      * @note Logs all color updates to serial console
      */
-    void updateColors(StaticJsonDocument<512> doc);
+    void updateColors(const JsonDocument &doc);
 
 public:
     /**
@@ -374,9 +672,10 @@ public:
      * @li Process DNS requests (x3 for responsive redirection)
      * @li Report connected client count changes
      * @li Handle loading animation state
-     * @li Broadcast button press events to clients
+     * @li Run the machine and draw the panel (runMachine()), or refresh the loading animation
+     * @li Collect panel input and publish it with the state changes to clients
+     *     (collectPanelInput(), publishUpdates())
      * @li Update server status LED
-     * @li Refresh display with current state
      * 
      * **Timing:**
      * - 5ms delay between DNS processing batches
@@ -387,7 +686,8 @@ public:
      * @note Includes appropriate delays to prevent system overload
      * 
      * @see handleLoadingAnimation()
-     * @see sendSignalValue()
+     * @see runMachine()
+     * @see publishUpdates()
      * @see runningServerLED()
      */
     void runServer();
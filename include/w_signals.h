@@ -0,0 +1,302 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @file w_signals.h
+ * @brief Compile-time table of the W machine control signals
+ *
+ * Every control signal is an entry of the Signal enum, and a set of signals (e.g. the
+ * signals selected for the next TAKT) is a 16-bit SignalMask with one bit per entry.
+ * Names and conflicts are constexpr tables indexed by the enum, so selecting a signal,
+ * checking it for conflicts and executing a TAKT need no strings, no hashing and no
+ * heap. The conflict matrix is derived at compile time from the registers, buses and
+ * memory each signal reads and writes (ACCESS), so checking a signal is one AND.
+ * Names are only used at the edges (serial debug, web messages).
+ *
+ * @author Bartosz Faruga / MrRooby
+ * @date 2025
+ */
+
+/**
+ * @enum Signal
+ * @brief Control signals of the W machine
+ */
+enum class Signal : uint8_t {
+    IL = 0,     ///< Increment register L
+    WEL,        ///< Bus A → register L
+    WYL,        ///< Register L → bus A
+    WYAD,       ///< Address field of register I → bus A
+    WEI,        ///< Bus S → register I
+    WEAK,       ///< JAML → register AK
+    DOD,        ///< AK + JAML → AK
+    ODE,        ///< AK - JAML → AK
+    PRZEP,      ///< Bus S → register AK
+    WYAK,       ///< Register AK → bus S
+    WEJA,       ///< Bus S → JAML
+    WEA,        ///< Bus A → register A
+    CZYT,       ///< Memory[A] → register S
+    PISZ,       ///< Register S → memory[A]
+    WES,        ///< Bus S → register S
+    WYS,        ///< Register S → bus S
+    COUNT,      ///< Number of signals
+    NONE = COUNT ///< No signal (e.g. the TAKT button or an unknown name)
+};
+
+/// Set of signals, bit n set for Signal n
+using SignalMask = uint16_t;
+
+namespace Signals {
+    constexpr size_t COUNT = static_cast<size_t>(Signal::COUNT);   ///< Number of signals
+
+    static_assert(COUNT <= 16, "SignalMask holds one bit per signal");
+
+    /** @brief Bit of a signal in a SignalMask */
+    constexpr SignalMask bit(Signal signal)
+    {
+        return static_cast<SignalMask>(1u << static_cast<uint8_t>(signal));
+    }
+
+    /// Signal names, indexed by Signal
+    constexpr const char *NAMES[COUNT] = {
+        "IL", "WEL", "WYL", "WYAD", "WEI", "WEAK", "DOD", "ODE",
+        "PRZEP", "WYAK", "WEJA", "WEA", "CZYT", "PISZ", "WES", "WYS"
+    };
+
+    /** @brief Name of a signal, or "" for Signal::NONE */
+    constexpr const char* name(Signal signal)
+    {
+        return (signal < Signal::COUNT) ? NAMES[static_cast<uint8_t>(signal)] : "";
+    }
+
+    /** @brief Compile-time string comparison used for the name lookup */
+    constexpr bool namesEqual(const char *a, const char *b)
+    {
+        while (*a && *a == *b) {
+            a++;
+            b++;
+        }
+        return *a == *b;
+    }
+
+    /**
+     * @brief Find a signal by name
+     *
+     * @param name Signal name (upper case, e.g. "WYL")
+     *
+     * @return The signal, or Signal::NONE if the name is unknown
+     */
+    constexpr Signal fromName(const char *name)
+    {
+        for (size_t n = 0; n < COUNT; n++) {
+            if (namesEqual(NAMES[n], name)) {
+                return static_cast<Signal>(n);
+            }
+        }
+        return Signal::NONE;
+    }
+
+    /**
+     * @enum Phase
+     * @brief Part of a TAKT in which a signal acts
+     *
+     * Signals of one TAKT act phase by phase, so bus drivers always put their register
+     * on the bus before the receivers latch it, whatever order the signals were
+     * selected in. CZYT loads S from memory before the drivers, which lets one TAKT read
+     * a word and put it on bus S (czyt wys). WEJA loads the ALU input before the ALU
+     * works on it (weja dod).
+     */
+    enum class Phase : uint8_t {
+        READ = 0,   ///< Memory → register S
+        DRIVE,      ///< Registers → buses
+        ALU_INPUT,  ///< Bus S → JAML
+        EXECUTE,    ///< ALU into AK, register S → memory
+        LATCH,      ///< Buses → registers, counter increment
+        COUNT       ///< Number of phases
+    };
+
+    /// Phase of every signal, indexed by Signal
+    constexpr Phase PHASES[COUNT] = {
+        Phase::LATCH,       // IL
+        Phase::LATCH,       // WEL
+        Phase::DRIVE,       // WYL
+        Phase::DRIVE,       // WYAD
+        Phase::LATCH,       // WEI
+        Phase::EXECUTE,     // WEAK
+        Phase::EXECUTE,     // DOD
+        Phase::EXECUTE,     // ODE
+        Phase::EXECUTE,     // PRZEP
+        Phase::DRIVE,       // WYAK
+        Phase::ALU_INPUT,   // WEJA
+        Phase::LATCH,       // WEA
+        Phase::READ,        // CZYT
+        Phase::EXECUTE,     // PISZ
+        Phase::LATCH,       // WES
+        Phase::DRIVE        // WYS
+    };
+
+    /** @brief Phase of a signal */
+    constexpr Phase phaseOf(Signal signal)
+    {
+        return PHASES[static_cast<uint8_t>(signal)];
+    }
+
+    /// Set of machine resources (registers, buses, memory), bit n set for resource n
+    using ResourceMask = uint16_t;
+
+    /// Resources read or written by the signals
+    namespace Resource {
+        constexpr ResourceMask L      = 1u << 0;    ///< Register L
+        constexpr ResourceMask I      = 1u << 1;    ///< Register I
+        constexpr ResourceMask AK     = 1u << 2;    ///< Register AK
+        constexpr ResourceMask A      = 1u << 3;    ///< Register A
+        constexpr ResourceMask S      = 1u << 4;    ///< Register S
+        constexpr ResourceMask JAML   = 1u << 5;    ///< ALU input JAML
+        constexpr ResourceMask BUS_A  = 1u << 6;    ///< Bus A
+        constexpr ResourceMask BUS_S  = 1u << 7;    ///< Bus S
+        constexpr ResourceMask MEMORY = 1u << 8;    ///< PAO memory
+        constexpr ResourceMask BUSES  = BUS_A | BUS_S;
+    }
+
+    /**
+     * @struct Access
+     * @brief Resources a signal reads and writes
+     */
+    struct Access {
+        ResourceMask reads;
+        ResourceMask writes;
+    };
+
+    /// Resource access of every signal, indexed by Signal
+    constexpr Access ACCESS[COUNT] = {
+        {Resource::L,                   Resource::L},       // IL
+        {Resource::BUS_A,               Resource::L},       // WEL
+        {Resource::L,                   Resource::BUS_A},   // WYL
+        {Resource::I,                   Resource::BUS_A},   // WYAD
+        {Resource::BUS_S,               Resource::I},       // WEI
+        {Resource::JAML,                Resource::AK},      // WEAK
+        {Resource::AK | Resource::JAML, Resource::AK},      // DOD
+        {Resource::AK | Resource::JAML, Resource::AK},      // ODE
+        {Resource::BUS_S,               Resource::AK},      // PRZEP
+        {Resource::AK,                  Resource::BUS_S},   // WYAK
+        {Resource::BUS_S,               Resource::JAML},    // WEJA
+        {Resource::BUS_A,               Resource::A},       // WEA
+        {Resource::A | Resource::MEMORY, Resource::S},      // CZYT
+        {Resource::A | Resource::S,     Resource::MEMORY},  // PISZ
+        {Resource::BUS_S,               Resource::S},       // WES
+        {Resource::S,                   Resource::BUS_S}    // WYS
+    };
+
+    /**
+     * @struct ConflictPair
+     * @brief Two signals that cannot be selected for the same TAKT
+     */
+    struct ConflictPair {
+        Signal first;
+        Signal second;
+    };
+
+    /// Conflicts of the hardware that do not follow from the resource access table
+    constexpr ConflictPair CONFLICT_PAIRS[] = {
+        {Signal::CZYT,  Signal::PISZ},  // one memory port: cannot read and write memory at once
+    };
+
+    /**
+     * @brief Check whether two signals cannot be selected for the same TAKT
+     *
+     * @li Bus contention: both drive the same bus
+     * @li Write-write: both write the same register or the memory, one result would be lost
+     * @li Read-write hazard: one reads what the other writes in the same phase, so the
+     *     value read would depend on the order inside the phase
+     * @li Hardware conflicts listed in CONFLICT_PAIRS
+     */
+    constexpr bool conflicts(Signal first, Signal second)
+    {
+        if (first == second) {
+            return false;
+        }
+
+        const Access &a = ACCESS[static_cast<uint8_t>(first)];
+        const Access &b = ACCESS[static_cast<uint8_t>(second)];
+
+        if (a.writes & b.writes) {
+            return true;
+        }
+        if (phaseOf(first) == phaseOf(second) && ((a.reads & b.writes) || (a.writes & b.reads))) {
+            return true;
+        }
+        for (const ConflictPair &pair : CONFLICT_PAIRS) {
+            if ((pair.first == first && pair.second == second) || (pair.first == second && pair.second == first)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** @brief Mask of the signals conflicting with a signal */
+    constexpr SignalMask conflictsOf(Signal signal)
+    {
+        SignalMask mask = 0;
+        for (size_t n = 0; n < COUNT; n++) {
+            if (conflicts(signal, static_cast<Signal>(n))) {
+                mask |= bit(static_cast<Signal>(n));
+            }
+        }
+        return mask;
+    }
+
+    /// Conflict matrix: conflict mask of every signal, indexed by Signal
+    constexpr SignalMask CONFLICTS[COUNT] = {
+        conflictsOf(Signal::IL),   conflictsOf(Signal::WEL),  conflictsOf(Signal::WYL),   conflictsOf(Signal::WYAD),
+        conflictsOf(Signal::WEI),  conflictsOf(Signal::WEAK), conflictsOf(Signal::DOD),   conflictsOf(Signal::ODE),
+        conflictsOf(Signal::PRZEP),conflictsOf(Signal::WYAK), conflictsOf(Signal::WEJA),  conflictsOf(Signal::WEA),
+        conflictsOf(Signal::CZYT), conflictsOf(Signal::PISZ), conflictsOf(Signal::WES),   conflictsOf(Signal::WYS),
+    };
+
+    /**
+     * @struct ExecutionOrder
+     * @brief Every signal, sorted by phase
+     */
+    struct ExecutionOrder {
+        Signal signals[COUNT] = {};
+    };
+
+    /** @brief Sort all signals by phase (signals of one phase keep their enum order) */
+    constexpr ExecutionOrder sortByPhase()
+    {
+        ExecutionOrder sorted;
+        size_t count = 0;
+        for (uint8_t phase = 0; phase < static_cast<uint8_t>(Phase::COUNT); phase++) {
+            for (size_t n = 0; n < COUNT; n++) {
+                if (static_cast<uint8_t>(PHASES[n]) == phase) {
+                    sorted.signals[count++] = static_cast<Signal>(n);
+                }
+            }
+        }
+        return sorted;
+    }
+
+    /// Order in which W_Machine::takt() executes the selected signals
+    constexpr ExecutionOrder EXECUTION_ORDER = sortByPhase();
+
+    /** @brief Check that every name maps back to its own signal */
+    constexpr bool hasUniqueNames()
+    {
+        for (size_t n = 0; n < COUNT; n++) {
+            if (fromName(NAMES[n]) != static_cast<Signal>(n)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static_assert(hasUniqueNames(), "Signal names must be unique and match the Signal enum");
+    static_assert((CONFLICTS[static_cast<uint8_t>(Signal::CZYT)] & bit(Signal::PISZ)) != 0, "Conflict table out of sync with the Signal enum");
+    static_assert((CONFLICTS[static_cast<uint8_t>(Signal::WYAK)] & bit(Signal::WYS)) && (CONFLICTS[static_cast<uint8_t>(Signal::WYL)] & bit(Signal::WYAD)),
+                  "Conflict matrix must reject two drivers on one bus");
+    static_assert((CONFLICTS[static_cast<uint8_t>(Signal::CZYT)] & bit(Signal::WYS)) == 0 && (CONFLICTS[static_cast<uint8_t>(Signal::WEJA)] & bit(Signal::DOD)) == 0,
+                  "Conflict matrix must allow the fetch (czyt wys) and the ALU steps (weja dod)");
+    static_assert(EXECUTION_ORDER.signals[0] == Signal::CZYT && EXECUTION_ORDER.signals[COUNT - 1] == Signal::WES,
+                  "Execution order must start with the memory read and end with the latches");
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "w_signals.h"
+
+/**
+ * @file w_trace.h
+ * @brief Execution trace of the W machine
+ *
+ * A fixed-capacity ring buffer holding one packed 8-byte TraceEntry per TAKT: the
+ * signals executed, the registers and buses they changed and the memory word written
+ * by PISZ. The buffer is allocated once, together with its owner, and the oldest
+ * entries are overwritten when it is full.
+ *
+ * Recording and reading are lock-free: the machine (single producer) publishes an entry
+ * by advancing an atomic counter, and any number of readers follow it with their own
+ * Cursor. A reader never blocks the machine; when it falls behind by more than the
+ * capacity, the skipped entries are counted in Cursor::dropped. So the trace can be
+ * streamed over USB serial while a program runs at full speed.
+ *
+ * @author Bartosz Faruga / MrRooby
+ * @date 2025
+ */
+
+/**
+ * @struct TraceEntry
+ * @brief One executed TAKT, packed into 8 bytes
+ */
+struct TraceEntry {
+    static constexpr uint8_t MEMORY_WRITTEN = 0x01;     ///< flags: PISZ wrote value to address
+    static constexpr uint8_t BUSES_SHIFT    = 1;        ///< flags: bit 1 + n set when W_Machine::Bus n was driven
+
+    SignalMask signals = 0;     ///< Signals executed
+    uint8_t registers = 0;      ///< Bit n set when W_Machine::Register n changed
+    uint8_t flags = 0;          ///< MEMORY_WRITTEN and the driven buses
+    uint16_t address = 0;       ///< Memory address written (when MEMORY_WRITTEN)
+    uint16_t value = 0;         ///< Word written, low 16 bits (when MEMORY_WRITTEN)
+};
+
+static_assert(sizeof(TraceEntry) == 8, "TraceEntry must stay packed into 8 bytes");
+
+class W_Trace
+{
+public:
+    static constexpr uint32_t CAPACITY = 1024;                  ///< Number of entries (power of 2, 8 KiB)
+    static constexpr size_t LINE_SIZE = 96;                     ///< Buffer size that fits any formatted entry
+
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "W_Trace::CAPACITY must be a power of 2");
+
+    /**
+     * @struct Cursor
+     * @brief Read position of one reader
+     */
+    struct Cursor {
+        uint32_t next = 0;      ///< Number of the next entry to read
+        uint32_t dropped = 0;   ///< Entries overwritten before this reader got to them
+    };
+
+private:
+    TraceEntry entries[CAPACITY];                               ///< Ring of entries, entry n is at n % CAPACITY
+    std::atomic<uint32_t> head{0};                              ///< Number of entries recorded so far, wraps around
+    std::atomic<bool> filled{false};                            ///< Set once CAPACITY entries were recorded
+
+public:
+    /**
+     * @brief Append an entry, overwriting the oldest one when the buffer is full
+     *
+     * Called by the machine after every TAKT. Must only be called from one context.
+     */
+    void record(const TraceEntry &entry);
+
+    /**
+     * @brief Copy the next entries of a reader
+     *
+     * Entries the machine overwrote before or during the copy are skipped and added
+     * to cursor.dropped, so the copied entries are always consistent.
+     *
+     * @param cursor Reader position, advanced past the copied entries
+     * @param out Destination of the entries
+     * @param max Size of out
+     *
+     * @return Number of entries copied; the first one is entry cursor.next - result
+     */
+    size_t read(Cursor &cursor, TraceEntry *out, size_t max) const;
+
+    /**
+     * @brief Cursor positioned before the last entries recorded
+     *
+     * @param count Number of recorded entries the cursor should return (at most CAPACITY - 1)
+     */
+    Cursor latest(uint32_t count) const;
+
+    /** @brief Number of entries recorded since the start, modulo 2^32 */
+    uint32_t getCount() const;
+
+    /**
+     * @brief Format an entry as one text line
+     *
+     * Example: `#42 CZYT WYS WEI IL | S I L | busS`, or with a memory write
+     * `#57 PISZ WYL WEA | A | busA | PAO[12]=12`.
+     *
+     * @param entry Entry to format
+     * @param number Entry number shown after '#'
+     * @param buffer Destination, LINE_SIZE bytes fit every entry
+     * @param size Size of buffer
+     *
+     * @return Length of the line (without the terminating 0)
+     */
+    static size_t format(const TraceEntry &entry, uint32_t number, char *buffer, size_t size);
+};
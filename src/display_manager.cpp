@@ -1,117 +1,259 @@
 #include "display_manager.h"
+#include <driver/rmt.h>
+
+/// Maps each element class to the ElementKind it is created for in the layout table
+template<typename T> struct ElementKindOf;
+template<> struct ElementKindOf<ThreeDigitDisplay> { static constexpr ElementKind value = ElementKind::THREE_DIGIT; };
+template<> struct ElementKindOf<PaODisplayLine>    { static constexpr ElementKind value = ElementKind::PAO_LINE; };
+template<> struct ElementKindOf<SignalLine>        { static constexpr ElementKind value = ElementKind::SIGNAL; };
+template<> struct ElementKindOf<BusLine>           { static constexpr ElementKind value = ElementKind::BUS; };
 
 
 DisplayManager::DisplayManager(const char *signalLineColorHEX, 
                                const char *displayColorHEX, 
                                const char *busColorHEX) 
 {
+    using LedLayout::indexOf;
+
+    // The output task can expand pixels through the snapshot before the first refresh
+    for (RgbColor &color : this->frontPalette) {
+        color = RgbColor(0, 0, 0);
+    }
+
     this->setDisplayColor(signalLineColorHEX, displayColorHEX, busColorHEX);
+    this->updatePalette();
 
-    this->stripR = new NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt0Ws2812xMethod>(LED_COUNT_R, LED_PORT_R);
-    this->stripL = new NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt1Ws2812xMethod>(LED_COUNT_L, LED_PORT_L);
-    
-    this->stripR->Begin();
-    this->stripL->Begin();
+    for (size_t n = 0; n < LedLayout::OUTPUT_COUNT; n++) {
+        const LedOutput &output = LedLayout::OUTPUTS[n];
+        uint16_t length = LedLayout::stripLength(n);
+
+        this->strips[n] = new LedStrip(length, output.pin, static_cast<NeoBusChannel>(output.channel));
+        this->wire[n]   = new uint8_t[length * FrameBuffer::BYTES_PER_PIXEL]();
+        this->frames[n] = new FrameBuffer(length);
+        this->fronts[n] = new FrameBuffer(length);
+    }
+
+    this->frameMutex = xSemaphoreCreateMutex();
+
+    xTaskCreatePinnedToCore(DisplayManager::outputTaskEntry, "LedOutput", OUTPUT_TASK_STACK_SIZE,
+                            this, OUTPUT_TASK_PRIORITY, &this->outputTaskHandle, OUTPUT_TASK_CORE);
     
-    this->initStripR();
-    this->initStripL();
-
-    this->signalLineMap = {
-        {"il",     this->il},
-        {"wel",    this->wel},
-        {"wyl",    this->wyl},
-        {"wyad1",  this->wyad1},
-        {"wyad2",  this->wyad2},
-        {"wei",    this->wei},
-        {"weja",   this->weja},
-        {"przep",  this->przep},
-        {"ode",    this->ode},
-        {"dod",    this->dod},
-        {"weak",   this->weak},
-        {"wyak",   this->wyak},
-        {"wea",    this->wea},
-        {"czyt",   this->czyt},
-        {"pisz",   this->pisz},
-        {"wes",    this->wes},
-        {"wys",    this->wys},
-        {"stop",   this->stop}
-    };
+    for (size_t n = 0; n < LedLayout::ELEMENT_COUNT; n++) {
+        const LayoutEntry &entry = LedLayout::ELEMENTS[n];
+        this->elements[n] = this->createElement(entry);
+
+        if (entry.kind == ElementKind::SIGNAL) {
+            this->signalLineMap[entry.name] = static_cast<SignalLine*>(this->elements[n]);
+        }
+    }
+
+    this->acc    = this->elementAt<indexOf("acc"),   ThreeDigitDisplay>();
+    this->a      = this->elementAt<indexOf("a"),     ThreeDigitDisplay>();
+    this->s      = this->elementAt<indexOf("s"),     ThreeDigitDisplay>();
+    this->c      = this->elementAt<indexOf("c"),     ThreeDigitDisplay>();
+    this->i      = this->elementAt<indexOf("i"),     ThreeDigitDisplay>();
+
+    this->il     = this->elementAt<indexOf("il"),    SignalLine>();
+    this->wel    = this->elementAt<indexOf("wel"),   SignalLine>();
+    this->wyl    = this->elementAt<indexOf("wyl"),   SignalLine>();
+    this->wyad1  = this->elementAt<indexOf("wyad1"), SignalLine>();
+    this->stop   = this->elementAt<indexOf("stop"),  SignalLine>();
+    this->wyad2  = this->elementAt<indexOf("wyad2"), SignalLine>();
+    this->wei    = this->elementAt<indexOf("wei"),   SignalLine>();
+    this->przep  = this->elementAt<indexOf("przep"), SignalLine>();
+    this->ode    = this->elementAt<indexOf("ode"),   SignalLine>();
+    this->dod    = this->elementAt<indexOf("dod"),   SignalLine>();
+    this->weak   = this->elementAt<indexOf("weak"),  SignalLine>();
+    this->weja   = this->elementAt<indexOf("weja"),  SignalLine>();
+    this->wyak   = this->elementAt<indexOf("wyak"),  SignalLine>();
+    this->wea    = this->elementAt<indexOf("wea"),   SignalLine>();
+    this->czyt   = this->elementAt<indexOf("czyt"),  SignalLine>();
+    this->pisz   = this->elementAt<indexOf("pisz"),  SignalLine>();
+    this->wes    = this->elementAt<indexOf("wes"),   SignalLine>();
+    this->wys    = this->elementAt<indexOf("wys"),   SignalLine>();
+
+    this->busA   = this->elementAt<indexOf("busA"),  BusLine>();
+    this->busS   = this->elementAt<indexOf("busS"),  BusLine>();
+
+    this->pao[0] = this->elementAt<indexOf("pao0"),  PaODisplayLine>();
+    this->pao[1] = this->elementAt<indexOf("pao1"),  PaODisplayLine>();
+    this->pao[2] = this->elementAt<indexOf("pao2"),  PaODisplayLine>();
+    this->pao[3] = this->elementAt<indexOf("pao3"),  PaODisplayLine>();
 
     this->clearDisplay();
 }
 
 DisplayManager::~DisplayManager()
 {
-    delete this->a;
-    delete this->wea;
-    delete this->pao[0];
-    delete this->czyt;
-    delete this->pisz;
-    delete this->pao[1];
-    delete this->pao[2];
-    delete this->pao[3];
-    delete this->s;
-    delete this->wes;
-    delete this->wys;
-    delete this->busA;
-
-    delete this->c;
-    delete this->wel;
-    delete this->wyl;
-    delete this->il;
-    delete this->wyad1;
-    delete this->stop;
-    delete this->wyad2;
-    delete this->i;
-    delete this->wei;
-    delete this->weja;
-    delete this->przep;
-    delete this->ode;
-    delete this->dod;
-    delete this->weak;
-    delete this->acc;
-    delete this->wyak;
-    delete this->busS;
-
-    delete this->stripR;
-    delete this->stripL;
+    if (this->outputTaskHandle) {
+        xSemaphoreTake(this->frameMutex, portMAX_DELAY);
+        vTaskDelete(this->outputTaskHandle);
+        xSemaphoreGive(this->frameMutex);
+    }
+    vSemaphoreDelete(this->frameMutex);
+
+    for (LedElement *element : this->elements) {
+        delete element;
+    }
+
+    for (size_t n = 0; n < LedLayout::OUTPUT_COUNT; n++) {
+        delete this->strips[n];
+        delete[] this->wire[n];
+        delete this->frames[n];
+        delete this->fronts[n];
+    }
+}
+
+void DisplayManager::outputTaskEntry(void *param)
+{
+    static_cast<DisplayManager*>(param)->outputTask();
+}
+
+void DisplayManager::outputTask()
+{
+    // Begin() installs the RMT driver, its WS2812 translator and its interrupt on
+    // the calling core, so the transmission interrupts stay off the Arduino loop core
+    for (LedStrip *strip : this->strips) {
+        strip->Begin();
+    }
+
+    size_t sendBytes[LedLayout::OUTPUT_COUNT] = {};
+    unsigned long lastFrameEnd = 0;
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        uint32_t sendCount = 0;
+        size_t frameBytes = 0;
+
+        xSemaphoreTake(this->frameMutex, portMAX_DELAY);
+
+        for (size_t n = 0; n < LedLayout::OUTPUT_COUNT; n++) {
+            uint16_t sendPixels = this->fronts[n]->getDirtyEnd();
+
+            sendBytes[n] = sendPixels * FrameBuffer::BYTES_PER_PIXEL;
+
+            if (sendPixels > 0) {
+                this->fronts[n]->expand(this->wire[n], this->frontPalette, sendPixels);
+                this->fronts[n]->resetDirty();
+                frameBytes += sendBytes[n];
+                sendCount++;
+            }
+        }
+
+        this->frameStats.queueDepth = 0;
+
+        xSemaphoreGive(this->frameMutex);
+
+        if (sendCount == 0)
+            continue;
+
+        // The strips only latch a frame after the data line stayed low for the reset time
+        unsigned long sinceLastFrame = micros() - lastFrameEnd;
+        if (sinceLastFrame < LATCH_MICROS) {
+            delayMicroseconds(LATCH_MICROS - sinceLastFrame);
+        }
+
+        unsigned long start = micros();
+
+        // Only the prefix up to the highest changed pixel is sent; the pixels behind it
+        // keep the color they latched from the previous frame. Every segment is started
+        // before waiting for any of them, so they transmit in parallel.
+        for (size_t n = 0; n < LedLayout::OUTPUT_COUNT; n++) {
+            if (sendBytes[n] > 0) {
+                rmt_write_sample(static_cast<rmt_channel_t>(LedLayout::OUTPUTS[n].channel), this->wire[n], sendBytes[n], false);
+            }
+        }
+
+        for (size_t n = 0; n < LedLayout::OUTPUT_COUNT; n++) {
+            if (sendBytes[n] > 0) {
+                rmt_wait_tx_done(static_cast<rmt_channel_t>(LedLayout::OUTPUTS[n].channel), portMAX_DELAY);
+            }
+        }
+
+        lastFrameEnd = micros();
+        uint32_t frameMicros = lastFrameEnd - start;
+
+        xSemaphoreTake(this->frameMutex, portMAX_DELAY);
+        this->frameStats.framesSent += sendCount;
+        this->frameStats.bytesSent  += frameBytes;
+        this->frameStats.averageBytesPerFrame = this->frameStats.bytesSent / this->frameStats.framesSent;
+        this->frameStats.lastFrameMicros = frameMicros;
+        if (frameMicros > this->frameStats.maxFrameMicros) {
+            this->frameStats.maxFrameMicros = frameMicros;
+        }
+        xSemaphoreGive(this->frameMutex);
+    }
+}
+
+LedElement* DisplayManager::createElement(const LayoutEntry &entry)
+{
+    PaletteIndex color = this->getKindColor(entry.kind);
+    FrameBuffer *frame = this->frames[entry.output];
+
+    switch (entry.kind) {
+        case ElementKind::THREE_DIGIT: return new ThreeDigitDisplay(frame, entry.offset, color);
+        case ElementKind::PAO_LINE:    return new PaODisplayLine(   frame, entry.offset, color);
+        case ElementKind::SIGNAL:      return new SignalLine(       frame, entry.offset, entry.length, color);
+        case ElementKind::BUS:         return new BusLine(          frame, entry.offset, entry.length, color);
+    }
+
+    return nullptr;
+}
+
+template<size_t Index, typename T>
+T* DisplayManager::elementAt()
+{
+    static_assert(Index < LedLayout::ELEMENT_COUNT, "LED layout: element name not found");
+    static_assert(LedLayout::ELEMENTS[Index].kind == ElementKindOf<T>::value, "LED layout: element kind mismatch");
+
+    return static_cast<T*>(this->elements[Index]);
+}
+
+PaletteIndex DisplayManager::getKindColor(const ElementKind kind)
+{
+    switch (kind) {
+        case ElementKind::THREE_DIGIT:
+        case ElementKind::PAO_LINE:
+            return PALETTE_DISPLAY;
+
+        case ElementKind::SIGNAL:
+            return PALETTE_SIGNAL;
+
+        case ElementKind::BUS:
+            return PALETTE_BUS;
+    }
+
+    return PALETTE_DISPLAY;
 }
 
-void DisplayManager::initStripR() {
-    // Initialize strips displays and signal lines
-    this->wyak   = new SignalLine(       this->stripR, 0, 34,  this->signalLineColor);
-    this->acc    = new ThreeDigitDisplay(this->stripR, 34,     this->displayColor);
-    this->wea    = new SignalLine(       this->stripR, 55, 3,  this->signalLineColor);
-    this->a      = new ThreeDigitDisplay(this->stripR, 58,     this->displayColor);
-    this->pao[0] = new PaODisplayLine(   this->stripR, 79,     this->displayColor);
-    this->pao[1] = new PaODisplayLine(   this->stripR, 128,    this->displayColor);
-    this->pisz   = new SignalLine(       this->stripR, 177, 3, this->signalLineColor);
-    this->czyt   = new SignalLine(       this->stripR, 180, 3, this->signalLineColor);
-    this->pao[2] = new PaODisplayLine(   this->stripR, 184,    this->displayColor);
-    this->pao[3] = new PaODisplayLine(   this->stripR, 233,    this->displayColor);
-    this->s      = new ThreeDigitDisplay(this->stripR, 282,    this->displayColor);
-    this->wes    = new SignalLine(       this->stripR, 303, 9, this->signalLineColor);
-    this->wys    = new SignalLine(       this->stripR, 312, 9, this->signalLineColor);
-    this->busS   = new BusLine(          this->stripR, 321, /*TODO liczba ledów magistrali*/78, this->busColor);
+PaletteIndex DisplayManager::getElementPalette(const DisplayElement element)
+{
+    switch (element) {
+        case DisplayElement::SIGNAL_LINE: return PALETTE_SIGNAL;
+        case DisplayElement::BUS_LINE:    return PALETTE_BUS;
+        default:                          return PALETTE_DISPLAY;
+    }
 }
 
-void DisplayManager::initStripL() {
-    // Initialize strips displays and signal lines
-    this->weja   = new SignalLine(       this->stripL, 0, 4,   this->signalLineColor);
-    this->wei    = new SignalLine(       this->stripL, 4, 4,   this->signalLineColor);
-    this->i      = new ThreeDigitDisplay(this->stripL, 8,      this->displayColor);
-    this->przep  = new SignalLine(       this->stripL, 29, 3,  this->signalLineColor);
-    this->ode    = new SignalLine(       this->stripL, 33, 3,  this->signalLineColor);
-    this->dod    = new SignalLine(       this->stripL, 36, 3,  this->signalLineColor);
-    this->weak   = new SignalLine(       this->stripL, 39, 3,  this->signalLineColor);
-    this->wyad1  = new SignalLine(       this->stripL, 42, 8,  this->signalLineColor);
-    this->stop   = new SignalLine(       this->stripL, 50, 16, this->signalLineColor);
-    this->wyad2  = new SignalLine(       this->stripL, 65, 36, this->signalLineColor);
-    this->wel    = new SignalLine(       this->stripL, 101, 3, this->signalLineColor);
-    this->wyl    = new SignalLine(       this->stripL, 104, 3, this->signalLineColor);
-    this->il     = new SignalLine(       this->stripL, 107, 3, this->signalLineColor);
-    this->c      = new ThreeDigitDisplay(this->stripL, 110,    this->displayColor);
-    this->busA   = new BusLine(          this->stripL, 131, /*TODO liczba ledów magistrali*/78, this->busColor);
+void DisplayManager::updatePalette()
+{
+    this->palette.set(PALETTE_SIGNAL, Palette::swapRG(this->signalLineColor));
+    this->palette.set(PALETTE_BUS,    Palette::swapRG(this->busColor));
+
+    this->palette.set(PALETTE_ERROR,  Palette::swapRG(this->errorColor));
+
+    this->setPaOPalette(PALETTE_DISPLAY,   this->displayColor);
+    this->setPaOPalette(PALETTE_HIGHLIGHT, this->highlightColor);
+}
+
+void DisplayManager::setPaOPalette(PaletteIndex base, const RgbColor &color)
+{
+    bool grey = (color.R == color.B);
+
+    this->palette.set(base,                                 color);
+    this->palette.set(static_cast<PaletteIndex>(base + 1),  grey ? Palette::swapRG(color) : Palette::swapRB(color));
+    this->palette.set(static_cast<PaletteIndex>(base + 2),  grey ? Palette::swapRB(color) : Palette::swapRG(color));
 }
 
 RgbColor DisplayManager::hexToRgbColor(std::string colorHEX)
@@ -156,58 +298,134 @@ void DisplayManager::loadingAnimation(){
 }
 
 void DisplayManager::clearDisplay() {
-    for (int i = 0; i < LED_COUNT_L; i++) {
-        this->stripL->SetPixelColor(i, RgbColor(0, 0, 0));
+    for (Flash &flash : this->flashes) {
+        this->stopFlash(flash.line);
+    }
+
+    for (LedElement *element : this->elements) {
+        element->clear();
+    }
+}
+
+void DisplayManager::flashSignalLine(SignalLine *line)
+{
+    if (line == nullptr)
+        return;
+
+    Flash *slot = nullptr;
+    for (Flash &flash : this->flashes) {
+        if (flash.line == line) {
+            slot = &flash;
+            break;
+        }
+        if (!slot && !flash.line)
+            slot = &flash;
     }
-    for (int i = 0; i < LED_COUNT_R; i++) {
-        this->stripR->SetPixelColor(i, RgbColor(0, 0, 0));
+
+    // All slots busy: the oldest flash is almost over, take its slot
+    if (!slot) {
+        slot = &this->flashes[0];
+        for (Flash &flash : this->flashes) {
+            if (flash.startTime < slot->startTime)
+                slot = &flash;
+        }
+        this->stopFlash(slot->line);
+    }
+
+    slot->line = line;
+    slot->startTime = millis();
+
+    line->setColor(PALETTE_ERROR);
+    line->turnOnLine(true);
+}
+
+void DisplayManager::stopFlash(SignalLine *line)
+{
+    if (line == nullptr)
+        return;
+
+    for (Flash &flash : this->flashes) {
+        if (flash.line == line) {
+            line->setColor(PALETTE_SIGNAL);
+            line->turnOnLine(false);
+            flash.line = nullptr;
+        }
+    }
+}
+
+void DisplayManager::updateFlashes()
+{
+    unsigned long now = millis();
+
+    for (Flash &flash : this->flashes) {
+        if (!flash.line)
+            continue;
+
+        unsigned long phase = (now - flash.startTime) / FLASH_INTERVAL;
+
+        if (phase >= 2 * FLASH_BLINKS)
+            this->stopFlash(flash.line);
+        else
+            flash.line->turnOnLine(phase % 2 == 0);
     }
 }
 
 void DisplayManager::refreshDisplay(){
-    this->stripL->Show();
-    this->stripR->Show();
+    bool publish = false;
+
+    this->updateFlashes();
+
+    xSemaphoreTake(this->frameMutex, portMAX_DELAY);
+
+    bool paletteChanged = this->palette.hasChanged();
+    if(paletteChanged){
+        memcpy(this->frontPalette, this->palette.data(), sizeof(this->frontPalette));
+        this->palette.clearChanged();
+    }
+
+    for (size_t n = 0; n < LedLayout::OUTPUT_COUNT; n++) {
+        if(paletteChanged){
+            this->frames[n]->markDirty();
+        }
+
+        if(this->frames[n]->isDirty()){
+            this->fronts[n]->copyFrom(*this->frames[n]);
+            this->frames[n]->resetDirty();
+            publish = true;
+        }
+        else {
+            this->frameStats.framesSkipped++;
+        }
+    }
+
+    if(publish){
+        this->frameStats.queueDepth++;
+        if(this->frameStats.queueDepth > this->frameStats.maxQueueDepth){
+            this->frameStats.maxQueueDepth = this->frameStats.queueDepth;
+        }
+    }
+
+    xSemaphoreGive(this->frameMutex);
+
+    if(publish){
+        xTaskNotifyGive(this->outputTaskHandle);
+    }
+}
+
+FrameStats DisplayManager::getFrameStats()
+{
+    xSemaphoreTake(this->frameMutex, portMAX_DELAY);
+    FrameStats stats = this->frameStats;
+    xSemaphoreGive(this->frameMutex);
+
+    return stats;
 }
 
 void DisplayManager::changeDisplayColor(const char *signalLineColorHEX, const char *displayColorHEX, const char *busColorHEX)
 {
     Serial.printf("[DisplayManager]: New Colors\n Signal Line = {%s}\n Display = {%s}\n Bus = {%s}\n", signalLineColorHEX, displayColorHEX, busColorHEX);   
     this->setDisplayColor(signalLineColorHEX, displayColorHEX, busColorHEX);
-    
-    // Update all display colors
-    if (this->a) this->a->setColor(this->displayColor);
-    if (this->s) this->s->setColor(this->displayColor);
-    if (this->c) this->c->setColor(this->displayColor);
-    if (this->i) this->i->setColor(this->displayColor);
-    if (this->acc) this->acc->setColor(this->displayColor);
-    
-    for (int i = 0; i < 4; ++i) {
-        if (this->pao[i]) this->pao[i]->setColor(this->displayColor);
-    }
-    
-    // Update signal line colors
-    if (this->il)     this->il->setColor(this->signalLineColor);
-    if (this->wel)    this->wel->setColor(this->signalLineColor);
-    if (this->wyl)    this->wyl->setColor(this->signalLineColor);
-    if (this->wyad1)  this->wyad1->setColor(this->signalLineColor);
-    if (this->wyad2)  this->wyad2->setColor(this->signalLineColor);
-    if (this->wei)    this->wei->setColor(this->signalLineColor);
-    if (this->weja)   this->weja->setColor(this->signalLineColor);
-    if (this->przep)  this->przep->setColor(this->signalLineColor);
-    if (this->ode)    this->ode->setColor(this->signalLineColor);
-    if (this->dod)    this->dod->setColor(this->signalLineColor);
-    if (this->weak)   this->weak->setColor(this->signalLineColor);
-    if (this->wyak)   this->wyak->setColor(this->signalLineColor);
-    if (this->wea)    this->wea->setColor(this->signalLineColor); 
-    if (this->czyt)   this->czyt->setColor(this->signalLineColor);
-    if (this->pisz)   this->pisz->setColor(this->signalLineColor);
-    if (this->wes)    this->wes->setColor(this->signalLineColor);
-    if (this->wys)    this->wys->setColor(this->signalLineColor);
-    if (this->stop)   this->stop->setColor(this->signalLineColor);
-     
-    // Update bus colors
-    if (this->busA) this->busA->setColor(this->busColor);
-    if (this->busS) this->busS->setColor(this->busColor);
+    this->updatePalette();
 }
 
 SignalLine* DisplayManager::getSignalLine(const std::string& signalName) {
@@ -253,10 +471,10 @@ void DisplayManager::blinkingAnimation(LedElement *display, const DisplayElement
         lastBlinkTime = currentTime;
 
         if (blinkState) {
-            display->setColor(getElementColor(type));
+            display->setColor(getElementPalette(type));
         }
         else {
-            display->setColor(RgbColor(0, 0, 0));
+            display->setColor(PALETTE_OFF);
         }
     }
 }
@@ -265,31 +483,27 @@ void DisplayManager::ledTestAnimation(int updateSpeedMillis, bool printInSerial,
 {
     long now = millis();
     
-    static int iL = 0;
-    static int iR = 0;
+    static uint16_t index[LedLayout::OUTPUT_COUNT] = {};
 
     if(reset){
-        iL = 0;
-        iR = 0;
+        for (uint16_t &i : index) {
+            i = 0;
+        }
     }
 
     if(now - this->lastRefreshTime >= updateSpeedMillis){
-        if(this->stripL){
-            this->stripL->SetPixelColor(iL, RgbColor(255, 0, 0));
-            this->stripL->SetPixelColor(iL - 1, RgbColor(0, 0, 0));
-            if(printInSerial) Serial.printf("[DisplayManager]: LEFT [%i]\n", iL);
-        }
-        if(this->stripR){
-            this->stripR->SetPixelColor(iR, RgbColor(255, 0, 0));
-            this->stripR->SetPixelColor(iR - 1, RgbColor(0, 0, 0));
-            if(printInSerial) Serial.printf("[DisplayManager]: RIGHT [%i]\n", iR);
-        }
+        this->palette.set(PALETTE_TEST, RgbColor(255, 0, 0));
 
-        if(iL < LED_COUNT_L){iL++;}
-        else if(iL >= LED_COUNT_L) {iL = 0;}
-        
-        if(iR < LED_COUNT_R){iR++;}
-        else if(iR >= LED_COUNT_R) {iR = 0;}
+        for (size_t n = 0; n < LedLayout::OUTPUT_COUNT; n++) {
+            FrameBuffer *frame = this->frames[n];
+
+            frame->setPixel(index[n], PALETTE_TEST);
+            if(index[n] > 0) frame->setPixel(index[n] - 1, PALETTE_OFF);
+            if(printInSerial) Serial.printf("[DisplayManager]: %s [%i]\n", LedLayout::OUTPUTS[n].name, index[n]);
+
+            if(index[n] < frame->getPixelCount()){index[n]++;}
+            else {index[n] = 0;}
+        }
 
         lastRefreshTime = now;
     }
@@ -298,16 +512,12 @@ void DisplayManager::ledTestAnimation(int updateSpeedMillis, bool printInSerial,
 void DisplayManager::controlAllLEDs(int red, int green, int blue)
 {
     RgbColor testColor(red, green, blue);
+    PaletteIndex index = (testColor == RgbColor(0, 0, 0)) ? PALETTE_OFF : PALETTE_TEST;
 
-    if(this->stripL){
-        for(int i = 0; i < LED_COUNT_L; i++){
-            this->stripL->SetPixelColor(i, testColor);
-        }
-    }
-    if(this->stripR){
-        for(int i = 0; i < LED_COUNT_R; i++){
-            this->stripR->SetPixelColor(i, testColor);
-        }
+    this->palette.set(PALETTE_TEST, testColor);
+
+    for (FrameBuffer *frame : this->frames) {
+        frame->fill(index);
     }
 }
 
@@ -319,3 +529,32 @@ void DisplayManager::showIP(const IPAddress ip)
         this->pao[i]->val->displayValue(ip[i], false);
     }
 }
+
+void DisplayManager::scrollText(const char *text, int row, bool reset)
+{
+    if(row < 0 || row > 3)
+        return;
+
+    if(reset){
+        this->scrollPosition = 0;
+    }
+
+    unsigned long now = millis();
+    if(!reset && now - this->lastScrollTime < SCROLL_INTERVAL)
+        return;
+
+    const int width = PaODisplayLine::TEXT_LENGTH;
+    const size_t length = strlen(text);
+
+    char window[width + 1];
+    for(int i = 0; i < width; i++){
+        size_t index = this->scrollPosition + i;
+        window[i] = (index >= width && index - width < length) ? text[index - width] : ' ';
+    }
+    window[width] = '\0';
+
+    this->pao[row]->displayText(window);
+
+    this->scrollPosition = (this->scrollPosition + 1) % (length + width);
+    this->lastScrollTime = now;
+}
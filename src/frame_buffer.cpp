@@ -0,0 +1,133 @@
+#include "frame_buffer.h"
+#include <string.h>
+
+FrameBuffer::FrameBuffer(uint16_t pixelCount) : pixelCount(pixelCount), dirtyEnd(pixelCount)
+{
+    this->data = new uint8_t[pixelCount]();
+}
+
+FrameBuffer::~FrameBuffer()
+{
+    delete[] this->data;
+}
+
+void FrameBuffer::setPixel(uint16_t index, PaletteIndex color)
+{
+    if (index >= this->pixelCount)
+        return;
+
+    if (this->data[index] != color) {
+        this->data[index] = color;
+        this->markDirtyUpTo(index + 1);
+    }
+}
+
+PaletteIndex FrameBuffer::getPixel(uint16_t index) const
+{
+    if (index >= this->pixelCount)
+        return PALETTE_OFF;
+
+    return static_cast<PaletteIndex>(this->data[index]);
+}
+
+void FrameBuffer::fill(PaletteIndex color)
+{
+    this->fill(0, this->pixelCount, color);
+}
+
+void FrameBuffer::fill(uint16_t start, uint16_t count, PaletteIndex color)
+{
+    count = this->clipCount(start, count);
+
+    uint8_t *pixel = this->data + start;
+    uint16_t changedEnd = 0;
+
+    for (uint16_t i = 0; i < count; i++) {
+        if (pixel[i] != color)
+            changedEnd = i + 1;
+        pixel[i] = color;
+    }
+
+    if (changedEnd)
+        this->markDirtyUpTo(start + changedEnd);
+}
+
+void FrameBuffer::writeMask(uint16_t start, uint16_t count, uint32_t mask, PaletteIndex onColor, PaletteIndex offColor)
+{
+    count = this->clipCount(start, count > 32 ? 32 : count);
+
+    uint8_t *pixel = this->data + start;
+    uint16_t changedEnd = 0;
+
+    for (uint16_t i = 0; i < count; i++, mask >>= 1) {
+        uint8_t color = (mask & 1) ? onColor : offColor;
+
+        if (pixel[i] != color)
+            changedEnd = i + 1;
+        pixel[i] = color;
+    }
+
+    if (changedEnd)
+        this->markDirtyUpTo(start + changedEnd);
+}
+
+void FrameBuffer::copyFrom(const FrameBuffer &source)
+{
+    if (source.pixelCount != this->pixelCount)
+        return;
+
+    memcpy(this->data, source.data, this->pixelCount);
+    this->markDirtyUpTo(source.dirtyEnd);
+}
+
+void FrameBuffer::expand(uint8_t *grb, const RgbColor *palette, uint16_t count) const
+{
+    count = this->clipCount(0, count);
+
+    for (uint16_t i = 0; i < count; i++, grb += BYTES_PER_PIXEL) {
+        const RgbColor &color = palette[this->data[i]];
+
+        grb[0] = color.G;
+        grb[1] = color.R;
+        grb[2] = color.B;
+    }
+}
+
+uint16_t FrameBuffer::clipCount(uint16_t start, uint16_t count) const
+{
+    if (start >= this->pixelCount)
+        return 0;
+
+    return (count > this->pixelCount - start) ? this->pixelCount - start : count;
+}
+
+void FrameBuffer::markDirtyUpTo(uint16_t end)
+{
+    if (end > this->dirtyEnd)
+        this->dirtyEnd = end;
+}
+
+bool FrameBuffer::isDirty() const
+{
+    return this->dirtyEnd > 0;
+}
+
+uint16_t FrameBuffer::getDirtyEnd() const
+{
+    return this->dirtyEnd;
+}
+
+void FrameBuffer::markDirty()
+{
+    this->dirtyEnd = this->pixelCount;
+}
+
+void FrameBuffer::resetDirty()
+{
+    this->dirtyEnd = 0;
+}
+
+uint16_t FrameBuffer::getPixelCount() const
+{
+    return this->pixelCount;
+}
@@ -70,10 +70,10 @@ HumanInterface::HumanInterface()
     this->controlOnboardLED(BOTTOM, LOW);
 }
 
-char* HumanInterface::getPressedButton()
+const PanelButton* HumanInterface::getPressedButton()
 {
     if(digitalRead(WYS_BTN) == LOW){
-        return buttons.at(16);
+        return &BUTTONS[16];
     }
 
     uint16_t currentState = 0;
@@ -101,7 +101,7 @@ char* HumanInterface::getPressedButton()
 
     for (int i = 0; i < 16; ++i) {
         if (debouncedState & (1 << i)) {
-            return buttons.at(i);
+            return &BUTTONS[i];
         }
     }
     
@@ -193,11 +193,11 @@ void HumanInterface::controlBacklightLED(int power)
 
 void HumanInterface::testButtons()
 {
-    char* button = this->getPressedButton();
-    static char* prevButton = nullptr;
+    const PanelButton* button = this->getPressedButton();
+    static const PanelButton* prevButton = nullptr;
 
     if(button != nullptr && prevButton != button) {
-        Serial.printf("[HumanInterface]: %s pressed\n", this->getPressedButton());
+        Serial.printf("[HumanInterface]: %s pressed\n", button->name);
     }
 
     prevButton = button;
@@ -1,27 +1,42 @@
 #include "led_element.h"
 
-LedElement::LedElement(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt0Ws2812xMethod> *strip0, int startIndex, RgbColor color) {
-    this->strip0 = strip0;
+LedElement::LedElement(FrameBuffer *frame, int startIndex, PaletteIndex color) {
+    this->frame = frame;
     this->color = color;
     this->startIndex = startIndex;
 }
 
-LedElement::LedElement(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt1Ws2812xMethod> *strip1, int startIndex, RgbColor color) {
-    this->strip1 = strip1;
-    this->color = color;
-    this->startIndex = startIndex;
+void LedElement::fillPixels(PaletteIndex color) {
+    this->frame->fill(this->startIndex, this->pixelCount, color);
 }
 
-void LedElement::setColor(RgbColor color) {
+void LedElement::writeMask(uint32_t mask, PaletteIndex color) {
+    this->frame->writeMask(this->startIndex, this->pixelCount, mask, color, PALETTE_OFF);
+}
+
+void LedElement::renderState(uint32_t state) {
+    if (state == this->renderedState && this->color == this->renderedColor)
+        return;
+
+    this->renderedState = state;
+    this->renderedColor = this->color;
+    this->render(state);
+}
+
+void LedElement::render(uint32_t state) {}
+
+void LedElement::setColor(PaletteIndex color) {
     this->color = color;
+
+    if (this->renderedState != NOT_RENDERED)
+        this->renderState(this->renderedState);
 }
 
-RgbColor LedElement::swapRG(const RgbColor &color)
-{
-    return RgbColor(color.G, color.R, color.B);
+void LedElement::clear() {
+    this->fillPixels(PALETTE_OFF);
+    this->invalidate();
 }
 
-RgbColor LedElement::swapRB(const RgbColor &color)
-{
-    return RgbColor(color.B, color.G, color.R);
+void LedElement::invalidate() {
+    this->renderedState = NOT_RENDERED;
 }
@@ -17,11 +17,8 @@
 
 /*
 ====================================== TODO ========================================
-- Odświeżanie wyświetlaczy po wykryciu zmiany koloru
-    Wyświetlacze chyba będą zmuszone do pamiętania swojego stanu kurwa mać
 - Korekta działania enkodera
 - korekta działania maszyny lokalne (jak działają wykluczające się sygnały)
-- miganie na czerwono w przypadku niedozwolonych sygnałów
 ====================================================================================
 */
 
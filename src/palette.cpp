@@ -0,0 +1,49 @@
+#include "palette.h"
+
+Palette::Palette()
+{
+    for (RgbColor &color : this->colors) {
+        color = RgbColor(0, 0, 0);
+    }
+}
+
+void Palette::set(PaletteIndex index, const RgbColor &color)
+{
+    if (index == PALETTE_OFF || index >= PALETTE_SIZE)
+        return;
+
+    if (this->colors[index] != color) {
+        this->colors[index] = color;
+        this->changed = true;
+    }
+}
+
+const RgbColor& Palette::get(PaletteIndex index) const
+{
+    return this->colors[(index < PALETTE_SIZE) ? index : PALETTE_OFF];
+}
+
+const RgbColor* Palette::data() const
+{
+    return this->colors;
+}
+
+bool Palette::hasChanged() const
+{
+    return this->changed;
+}
+
+void Palette::clearChanged()
+{
+    this->changed = false;
+}
+
+RgbColor Palette::swapRG(const RgbColor &color)
+{
+    return RgbColor(color.G, color.R, color.B);
+}
+
+RgbColor Palette::swapRB(const RgbColor &color)
+{
+    return RgbColor(color.B, color.G, color.R);
+}
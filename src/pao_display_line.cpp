@@ -1,26 +1,31 @@
 #include "pao_display_line.h"
 
-PaODisplayLine::PaODisplayLine(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt0Ws2812xMethod>* strip0, int startIndex, RgbColor color)
-    : LedElement(strip0, startIndex, color) {
+PaODisplayLine::PaODisplayLine(FrameBuffer *frame, int startIndex, PaletteIndex color)
+    : LedElement(frame, startIndex, color) {
         this->baseColor = color;
+        this->pixelCount = 49;
         
-        this->addr = new TwoDigitDisplay(this->strip0, this->startIndex, this->color);
-        this->val  = new ThreeDigitDisplay(this->strip0, this->startIndex + 14, (color.R == color.B) ? swapRG(color) : swapRB(color));
-        this->arg  = new TwoDigitDisplay(this->strip0, this->startIndex + 35, this->color);
+        this->addr = new TwoDigitDisplay(this->frame, this->startIndex, this->color);
+        this->val  = new ThreeDigitDisplay(this->frame, this->startIndex + 14, valueColor(color));
+        this->arg  = new TwoDigitDisplay(this->frame, this->startIndex + 35, argumentColor(color));
 }
 
-PaODisplayLine::PaODisplayLine(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt1Ws2812xMethod>* strip1, int startIndex, RgbColor color)
-    : LedElement(strip1, startIndex, color) {
-        this->baseColor = color;
-
-        this->addr = new TwoDigitDisplay(this->strip1, this->startIndex, this->color);
-        this->val  = new ThreeDigitDisplay(this->strip1, this->startIndex + 14, (color.R == color.B) ? swapRG(color) : swapRB(color));
-        this->arg  = new TwoDigitDisplay(this->strip1, this->startIndex + 35, this->color);
+PaODisplayLine::~PaODisplayLine()
+{
+    delete this->addr;
+    delete this->val;
+    delete this->arg;
 }
 
-
-void PaODisplayLine::displayLine(int addr, int val, int arg)
+void PaODisplayLine::displayLine(int addr, int val, int arg, bool hex)
 {
+    if(hex){
+        this->addr->displayHex(addr);
+        this->val->displayHex(val);
+        this->arg->displayHex(arg);
+        return;
+    }
+
     this->addr->displayValue(addr);
     this->val->displayValue(val);
     this->arg->displayValue(arg);
@@ -41,6 +46,19 @@ void PaODisplayLine::displayLettersOnArgField(const char firstLetter, const char
     this->arg->displayLetters(firstLetter, secondLetter);
 }
 
+void PaODisplayLine::displayText(const char *text)
+{
+    char window[TEXT_LENGTH];
+
+    for (int i = 0; i < TEXT_LENGTH; i++) {
+        window[i] = *text ? *text++ : ' ';
+    }
+
+    this->addr->displayLetters(window[0], window[1]);
+    this->val->displayLetters(window[2], window[3], window[4]);
+    this->arg->displayLetters(window[5], window[6]);
+}
+
 void PaODisplayLine::loadingAnimation(){
     this->addr->loadingAnimation();
     this->val->loadingAnimation();
@@ -48,26 +66,36 @@ void PaODisplayLine::loadingAnimation(){
 }
 
 
-void PaODisplayLine::applyColor(RgbColor color)
+PaletteIndex PaODisplayLine::valueColor(PaletteIndex color)
+{
+    return (color == PALETTE_OFF) ? PALETTE_OFF : static_cast<PaletteIndex>(color + 1);
+}
+
+PaletteIndex PaODisplayLine::argumentColor(PaletteIndex color)
+{
+    return (color == PALETTE_OFF) ? PALETTE_OFF : static_cast<PaletteIndex>(color + 2);
+}
+
+void PaODisplayLine::applyColor(PaletteIndex color)
 {
     this->color = color;
     this->addr->setColor(color);
-    this->val->setColor((color.R == color.B) ? swapRG(color) : swapRB(color));
-    this->arg->setColor((color.R == color.B) ? swapRB(color) : swapRG(color));
+    this->val->setColor(valueColor(color));
+    this->arg->setColor(argumentColor(color));
 }
 
-void PaODisplayLine::setColor(RgbColor color)
+void PaODisplayLine::setColor(PaletteIndex color)
 {
     this->baseColor = color;
     applyColor(color);
 }
 
-RgbColor PaODisplayLine::getColor()
+PaletteIndex PaODisplayLine::getColor()
 {
     return this->baseColor;
 }
 
-void PaODisplayLine::setTemporaryColor(RgbColor color)
+void PaODisplayLine::setTemporaryColor(PaletteIndex color)
 {
     applyColor(color);
 }
@@ -76,3 +104,10 @@ void PaODisplayLine::restoreColor()
 {
     applyColor(this->baseColor);
 }
+
+void PaODisplayLine::invalidate()
+{
+    this->addr->invalidate();
+    this->val->invalidate();
+    this->arg->invalidate();
+}
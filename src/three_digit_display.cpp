@@ -1,21 +1,12 @@
 #include "three_digit_display.h"
 
-ThreeDigitDisplay::ThreeDigitDisplay(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt0Ws2812xMethod> *strip0, int startIndex, RgbColor color)
-    : LedElement(strip0, startIndex, color){
+ThreeDigitDisplay::ThreeDigitDisplay(FrameBuffer *frame, int startIndex, PaletteIndex color)
+    : LedElement(frame, startIndex, color){
     this->pixelCount = 21;
     
-    this->display[0] = Segment(strip0, startIndex, color);
-    this->display[1] = Segment(strip0, startIndex + 7, color);
-    this->display[2] = Segment(strip0, startIndex + 14, color);
-}
-
-ThreeDigitDisplay::ThreeDigitDisplay(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt1Ws2812xMethod> *strip1, int startIndex, RgbColor color)
-    : LedElement(strip1, startIndex, color){
-    this->pixelCount = 21;
-
-    this->display[0] = Segment(strip1, startIndex, color);
-    this->display[1] = Segment(strip1, startIndex + 7, color);
-    this->display[2] = Segment(strip1, startIndex + 14, color);
+    this->display[0] = Segment(frame, startIndex, color);
+    this->display[1] = Segment(frame, startIndex + 7, color);
+    this->display[2] = Segment(frame, startIndex + 14, color);
 }
 
 void ThreeDigitDisplay::displayValue(int value, bool enableLeadingZero){
@@ -28,15 +19,21 @@ void ThreeDigitDisplay::displayValue(int value, bool enableLeadingZero){
     int tens = (value / 10) % 10;
     int ones = value % 10;
 
-    this->display[0].displayNumber(enableLeadingZero ? huns : 11); // 11 is out of range for displayNumber, which turns off the segment
+    this->display[0].displayNumber(enableLeadingZero ? huns : Segment::BLANK);
     if(!enableLeadingZero){
-        if(huns == 0)
-            tens == 11;
+        if(huns == 0 && tens == 0)
+            tens = Segment::BLANK;
     }
     this->display[1].displayNumber(tens);
     this->display[2].displayNumber(ones);
 }
 
+void ThreeDigitDisplay::displayHex(int value){
+    this->display[0].displayNumber((value >> 8) & 0xF);
+    this->display[1].displayNumber((value >> 4) & 0xF);
+    this->display[2].displayNumber(value & 0xF);
+}
+
 void ThreeDigitDisplay::displayLetters(const char firstLetter, const char secondLetter, const char thirdLetter)
 {
     this->display[0].displayLetter(firstLetter);
@@ -50,7 +47,7 @@ void ThreeDigitDisplay::loadingAnimation(){
     this->display[2].loadingAnimation();
 }
 
-void ThreeDigitDisplay::setColor(RgbColor color){
+void ThreeDigitDisplay::setColor(PaletteIndex color){
     this->color = color;
 
     this->display[0].setColor(color);
@@ -58,3 +55,9 @@ void ThreeDigitDisplay::setColor(RgbColor color){
     this->display[2].setColor(color);
 }
 
+void ThreeDigitDisplay::invalidate()
+{
+    this->display[0].invalidate();
+    this->display[1].invalidate();
+    this->display[2].invalidate();
+}
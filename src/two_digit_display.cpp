@@ -1,21 +1,12 @@
 #include "two_digit_display.h"
 
-TwoDigitDisplay::TwoDigitDisplay(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt0Ws2812xMethod>* strip0, int startIndex, RgbColor color)
-    : LedElement(strip0, startIndex, color)
+TwoDigitDisplay::TwoDigitDisplay(FrameBuffer *frame, int startIndex, PaletteIndex color)
+    : LedElement(frame, startIndex, color)
 {
     this->pixelCount = 14;
 
-    this->display[0] = Segment(strip0, startIndex, color);
-    this->display[1] = Segment(strip0, startIndex + 7, color);
-}
-
-TwoDigitDisplay::TwoDigitDisplay(NeoPixelBus<NeoGrbFeature, NeoEsp32Rmt1Ws2812xMethod>* strip1, int startIndex, RgbColor color)
-    : LedElement(strip1, startIndex, color)
-{
-    this->pixelCount = 14;
-
-    this->display[0] = Segment(strip1, startIndex, color);
-    this->display[1] = Segment(strip1, startIndex + 7, color);
+    this->display[0] = Segment(frame, startIndex, color);
+    this->display[1] = Segment(frame, startIndex + 7, color);
 }
 
 void TwoDigitDisplay::displayValue(int value, bool enableLeadingZero)
@@ -30,10 +21,16 @@ void TwoDigitDisplay::displayValue(int value, bool enableLeadingZero)
     int tens = (value / 10) % 10;
     int ones = value % 10;
 
-    this->display[0].displayNumber(enableLeadingZero ? tens : 11);
+    this->display[0].displayNumber(enableLeadingZero ? tens : Segment::BLANK);
     this->display[1].displayNumber(ones);
 }
 
+void TwoDigitDisplay::displayHex(int value)
+{
+    this->display[0].displayNumber((value >> 4) & 0xF);
+    this->display[1].displayNumber(value & 0xF);
+}
+
 void TwoDigitDisplay::displayLetters(const char firstLetter, const char secondLetter)
 {
     this->display[0].displayLetter(firstLetter);
@@ -46,10 +43,16 @@ void TwoDigitDisplay::loadingAnimation()
     this->display[1].loadingAnimation();
 }
 
-void TwoDigitDisplay::setColor(RgbColor color)
+void TwoDigitDisplay::setColor(PaletteIndex color)
 {
     this->color = color;
     
     this->display[0].setColor(color);
     this->display[1].setColor(color);
 }
+
+void TwoDigitDisplay::invalidate()
+{
+    this->display[0].invalidate();
+    this->display[1].invalidate();
+}
@@ -0,0 +1,126 @@
+#include "w_history.h"
+
+const W_Machine::Delta& W_History::deltaAt(Position from) const
+{
+    return this->deltas[from & (CAPACITY - 1)];
+}
+
+uint32_t W_History::checkpointSlot(Position checkpoint)
+{
+    return (checkpoint / CHECKPOINT_INTERVAL) % CHECKPOINT_COUNT;
+}
+
+void W_History::reset(const W_Machine &machine)
+{
+    this->oldest = 0;
+    this->newest = 0;
+    this->position = 0;
+    machine.saveState(this->checkpoints[checkpointSlot(0)]);
+}
+
+void W_History::record(const W_Machine::Delta &delta, const W_Machine &machine)
+{
+    // A change made in the past starts a new future
+    this->newest = this->position;
+
+    this->deltas[this->newest & (CAPACITY - 1)] = delta;
+    this->newest++;
+    this->position = this->newest;
+
+    // Truncating never brings back forgotten deltas, so oldest only moves forward
+    if(this->newest - this->oldest > CAPACITY){
+        this->oldest = this->newest - CAPACITY;
+    }
+
+    if((this->newest & (CHECKPOINT_INTERVAL - 1)) == 0){
+        machine.saveState(this->checkpoints[checkpointSlot(this->newest)]);
+    }
+}
+
+uint32_t W_History::seek(W_Machine &machine, Position target)
+{
+    Position oldest = this->oldest;
+    if(target < oldest)       target = oldest;
+    if(target > this->newest) target = this->newest;
+
+    Position distance = (target > this->position) ? target - this->position : this->position - target;
+
+    // Nearest checkpoint below and above the target, when they are still kept
+    Position below = target & ~static_cast<Position>(CHECKPOINT_INTERVAL - 1);
+    Position above = below + CHECKPOINT_INTERVAL;
+
+    if(below >= oldest && target - below < distance && (above > this->newest || target - below <= above - target)){
+        machine.loadState(this->checkpoints[checkpointSlot(below)]);
+        this->position = below;
+    }
+    else if(above <= this->newest && above - target < distance){
+        machine.loadState(this->checkpoints[checkpointSlot(above)]);
+        this->position = above;
+    }
+
+    uint32_t applied = 0;
+    while(this->position > target){
+        this->position--;
+        machine.applyDelta(this->deltaAt(this->position));
+        applied++;
+    }
+    while(this->position < target){
+        machine.applyDelta(this->deltaAt(this->position));
+        this->position++;
+        applied++;
+    }
+
+    return applied;
+}
+
+bool W_History::stepBack(W_Machine &machine)
+{
+    if(this->position <= this->oldest){
+        return false;
+    }
+
+    this->position--;
+    machine.applyDelta(this->deltaAt(this->position));
+    return true;
+}
+
+bool W_History::stepForward(W_Machine &machine)
+{
+    if(this->position >= this->newest){
+        return false;
+    }
+
+    machine.applyDelta(this->deltaAt(this->position));
+    this->position++;
+    return true;
+}
+
+void W_History::truncate()
+{
+    this->newest = this->position;
+}
+
+W_History::Position W_History::getPosition() const
+{
+    return this->position;
+}
+
+W_History::Position W_History::getNewest() const
+{
+    return this->newest;
+}
+
+W_History::Position W_History::getOldest() const
+{
+    return this->oldest;
+}
+
+bool W_History::isLive() const
+{
+    return this->position == this->newest;
+}
+
+SignalMask W_History::getNextSignals() const
+{
+    return (this->position < this->newest) ? this->deltaAt(this->position).signals : 0;
+}
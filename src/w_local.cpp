@@ -1,43 +1,22 @@
 #include "w_local.h"
 
-
-
-const std::unordered_map<std::string, W_Local::CommandFunction> W_Local::signalMap = {
-    {"IL",   &W_Local::il},
-    {"WEL",  &W_Local::wel},
-    {"WYL",  &W_Local::wyl},
-    {"WYAD", &W_Local::wyad},
-    {"WEI",  &W_Local::wei},
-    {"WEAK", &W_Local::weak},
-    {"DOD",  &W_Local::dod},
-    {"ODE",  &W_Local::ode},
-    {"PRZEP",&W_Local::przep},
-    {"WYAK", &W_Local::wyak},
-    {"WEJA", &W_Local::weja},
-    {"WEA",  &W_Local::wea},
-    {"CZYT", &W_Local::czyt},
-    {"PISZ", &W_Local::pisz},
-    {"WES",  &W_Local::wes},
-    {"WYS",  &W_Local::wys}
-};
-
-
-const std::unordered_map<std::string, std::vector<std::string>> W_Local::signalConflicts = {
-    {"CZYT",  {"PISZ"}},
-    {"PISZ",  {"CZYT"}},
-
-    {"WYAK",  {"WYS"}},
-    {"WYS",   {"WYAK"}},
-    
-    {"IL",    {"WEL"}},
-    {"WEL",   {"IL"}},
-    
-    {"DOD",   {"ODE", "PRZEP"}},
-    {"ODE",   {"DOD", "PRZEP"}},
-    {"PRZEP", {"DOD", "ODE"}},
-    
-    {"WYL",   {"WYAD"}},
-    {"WYAD",  {"WYL"}}
+const W_Local::SignalView W_Local::signalViews[Signals::COUNT] = {
+    {&DisplayManager::il,    nullptr},                  // IL
+    {&DisplayManager::wel,   nullptr},                  // WEL
+    {&DisplayManager::wyl,   nullptr},                  // WYL
+    {&DisplayManager::wyad1, &DisplayManager::wyad2},   // WYAD
+    {&DisplayManager::wei,   nullptr},                  // WEI
+    {&DisplayManager::weak,  nullptr},                  // WEAK
+    {&DisplayManager::dod,   nullptr},                  // DOD
+    {&DisplayManager::ode,   nullptr},                  // ODE
+    {&DisplayManager::przep, nullptr},                  // PRZEP
+    {&DisplayManager::wyak,  nullptr},                  // WYAK
+    {&DisplayManager::weja,  nullptr},                  // WEJA
+    {&DisplayManager::wea,   nullptr},                  // WEA
+    {&DisplayManager::czyt,  nullptr},                  // CZYT
+    {&DisplayManager::pisz,  nullptr},                  // PISZ
+    {&DisplayManager::wes,   nullptr},                  // WES
+    {&DisplayManager::wys,   nullptr}                   // WYS
 };
 
 W_Local::W_Local(DisplayManager *dispMan, HumanInterface *humInter)
@@ -45,337 +24,368 @@ W_Local::W_Local(DisplayManager *dispMan, HumanInterface *humInter)
     this->dispMan  = dispMan;
     this->humInter = humInter;
 
-    initRegisters();
+    this->machine.attachTrace(&this->trace);
+    this->machine.attachHistory(&this->history);
+    this->history.reset(this->machine);
 }
 
 W_Local::~W_Local(){}
 
-template<size_t N>
-uint8_t W_Local::binaryTo_uint8_t(std::bitset<N> number)
+void W_Local::refreshDisplay()
 {
-    uint8_t result = 0;
+    if(this->dispMan){
+        MachineChanges changes = this->machine.takeChanges();
+        this->lastChanges = changes;
 
-    if(!number.none()){
-        for(int i = 0; i < N; i++){
-            result += number[i] * std::pow(2, i);
+        // Three digit displays
+        for(uint8_t reg = W_Machine::regL; reg <= W_Machine::regS; reg++){
+            if(changes.registers & (1 << reg)){
+                ThreeDigitDisplay *display = this->getSelectedDisplay(static_cast<Register>(reg));
+                if(!display) continue;
+
+                W_Machine::Word value = this->machine.getRegister(static_cast<Register>(reg));
+                if(HEX_DISPLAY) display->displayHex(value);
+                else            display->displayValue(value);
+            }
         }
-    }
 
-    return result;
-}
+        // Signal lines
+        if(changes.signals){
+            SignalMask selected = this->machine.getSelectedSignals();
 
-uint8_t W_Local::getPaOAddr()
-{
-    return binaryTo_uint8_t(A);
-}
+            // Only the lines of signals that were selected or deselected are drawn
+            for(SignalMask toggled = selected ^ this->drawnSignals; toggled; toggled &= toggled - 1){
+                uint8_t n = __builtin_ctz(toggled);
+                bool active = selected & (1u << n);
 
-void W_Local::initRegisters()
-{
-    this->A = _5Bit("00000");
-    this->busA = _5Bit("00000");
-    this->S = _8Bit("00000000");
-    this->I = _8Bit("00000000");
-    this->L = _5Bit("00000000");
-    this->AK = _8Bit("00000000");
-}
+                SignalLine *line = this->dispMan->*signalViews[n].line;
+                if(line){
+                    this->dispMan->stopFlash(line);
+                    line->turnOnLine(active);
+                }
 
-void W_Local::il()
-{
-    _5Bit one("00001");
-    while(one != 0){
-        _5Bit carry = L & one;
-        L ^= one;
-        one = carry << 1;
+                if(signalViews[n].extraLine){
+                    SignalLine *extraLine = this->dispMan->*signalViews[n].extraLine;
+                    if(extraLine){
+                        this->dispMan->stopFlash(extraLine);
+                        extraLine->turnOnLine(active);
+                    }
+                }
+            }
+
+            this->drawnSignals = selected;
+        }
+
+        //PaO
+        this->refreshPaOLines(changes);
+
+        //Bus lines
+        this->refreshBUSLines(changes.buses);
+
+        // STOP line
+        bool halted = this->sequencer.isHalted();
+        if(halted != this->stopLit){
+            if(this->dispMan->stop) this->dispMan->stop->turnOnLine(halted);
+            this->stopLit = halted;
+        }
+        
+        this->dispMan->refreshDisplay();
     }
 }
 
-void W_Local::wel()
+void W_Local::refreshPaOLines(const MachineChanges &changes)
 {
-    L = busA;
-}
+    uint32_t highlight = this->machine.getRegister(W_Machine::regA) - PaORangeLow;
 
-void W_Local::wyl()
-{
-    busA = L;
-}
+    for(uint8_t i = 0; i < PAO_ROWS; i++){
+        PaODisplayLine *line = this->dispMan->pao[i];
+        if(!line)
+            continue;
 
-void W_Local::wyad()
-{
-    for(int i = 0; i < 5; i++){
-        busA[i] = I[i];
+        uint16_t address = i + PaORangeLow;
+
+        // Color changes redraw the retained digits, so the highlight costs nothing
+        // when the row itself did not change
+        if(i == highlight && this->PaORangeHighlight != i){
+            line->setTemporaryColor(PALETTE_HIGHLIGHT);
+        }
+        else if(i != highlight && this->PaORangeHighlight == i){
+            line->restoreColor();
+        }
+
+        if(this->PaOViewChanged || changes.memory.test(address)){
+            W_Machine::Word word = this->machine.getMemory(address);
+            line->displayLine(address, word, W_Machine::GEOMETRY.opcode(word), HEX_DISPLAY);
+        }
     }
-}
 
-void W_Local::wei()
-{
-    I = busS;
+    this->PaORangeHighlight = (highlight < PAO_ROWS) ? highlight : 0xFF;
+    this->PaOViewChanged = false;
 }
 
-void W_Local::weak()
+void W_Local::refreshBUSLines(uint8_t buses)
 {
-    AK = JAML;
-}
+    unsigned long now = millis();
+    BusLine *lines[W_Machine::BUS_COUNT] = {this->dispMan->busA, this->dispMan->busS};
 
-void W_Local::dod()
-{
-    AK |= JAML;
+    for(uint8_t bus = 0; bus < W_Machine::BUS_COUNT; bus++){
+        if(buses & (1 << bus)){
+            if(lines[bus]) lines[bus]->turnOnLine(true);
+            this->busTurnOnTime[bus] = now;
+            this->busLit[bus] = true;
+        }
+        else if(this->busLit[bus] && now - this->busTurnOnTime[bus] >= BUS_LIGHT_UP_MILLIS){
+            if(lines[bus]) lines[bus]->turnOnLine(false);
+            this->busLit[bus] = false;
+        }
+    }
 }
 
-void W_Local::ode()
+void W_Local::readButtonInputs()
 {
-    _8Bit JAML_COPY = JAML;  
-    while (JAML_COPY.any()){
-        _8Bit borrow = ~AK & JAML_COPY; // NOT A AND B
-        AK  = AK ^ JAML_COPY; // A XOR B
-        JAML_COPY = borrow << 1; // borrow shift right by 1
+    const PanelButton* button = this->humInter->getPressedButton();
+
+    if(button != this->lastPressedButton) {
+        if(button != nullptr){
+            Serial.println(button->name);
+
+            if(this->historyMode){
+                this->resumeFromHistory();
+            }
+
+            if(button->isTakt()){
+                this->pressTakt();
+            }
+            else {
+                this->pressSignal(button->signal);
+            }
+        }
+
+        this->lastPressedButton = button;
     }
 }
 
-void W_Local::przep()
+void W_Local::pressTakt()
 {
-    AK = busS;
+    if(this->sequencer.isRunning()){
+        this->sequencer.stop();
+        Serial.println("[W_LOCAL]: Clock stopped");
+    }
+    else if(this->machine.getSelectedSignals() == 0){
+        this->sequencer.start(micros());
+        this->turboTakts = 0;
+        this->turboReportTime = millis();
+        Serial.printf("[W_LOCAL]: Clock started at %s\n", W_Sequencer::SPEEDS[this->sequencer.getSpeed()].label);
+    }
+    else {
+        this->machine.takt();
+    }
 }
 
-void W_Local::wyak()
+void W_Local::pressSignal(Signal signal)
 {
-    busS = AK;
-}
+    if(this->sequencer.isRunning()){
+        Serial.printf("[W_LOCAL][DEBUG]: Signal '%s' ignored while the clock runs\n", Signals::name(signal));
+        return;
+    }
 
-void W_Local::weja()
-{
-    JAML = busS;
-}
+    Signal conflict = Signal::NONE;
 
-void W_Local::wea()
-{
-    A = busA;
+    if(!this->machine.toggleSignal(signal, &conflict)){
+        Serial.printf("[W_LOCAL][DEBUG]: Signal '%s' conflicts with '%s'\n", 
+                    Signals::name(signal), Signals::name(conflict));
+        this->flashRejectedSignal(signal);
+    }
 }
 
-void W_Local::czyt()
+void W_Local::flashRejectedSignal(Signal signal)
 {
-    uint8_t adres = binaryTo_uint8_t(A);
-    
-    S = PaO[adres];
-}
+    const SignalView &view = signalViews[static_cast<uint8_t>(signal)];
 
-void W_Local::pisz()
-{
-    uint8_t adres = binaryTo_uint8_t(A);
-    
-    PaO[adres] = S; 
+    this->dispMan->flashSignalLine(this->dispMan->*view.line);
+    if(view.extraLine){
+        this->dispMan->flashSignalLine(this->dispMan->*view.extraLine);
+    }
 }
 
-void W_Local::wes()
+void W_Local::insertMode(Register selectedRegister)
 {
-    S = busS;
-}
+    EncoderState enc = this->humInter->getEncoderState();
+    W_Machine::Word regVal = this->machine.getRegister(selectedRegister);
+    const uint32_t wordMask = W_Machine::GEOMETRY.wordMask();
 
-void W_Local::wys()
-{
-    busS = S;
+    // Wrapped to a word here; the machine core truncates address registers further
+    if(enc == DOWN){
+        this->machine.setRegister(selectedRegister, (regVal + 1UL) & wordMask);
+    }
+    else if(enc == UP){
+        this->machine.setRegister(selectedRegister, (regVal - 1UL) & wordMask);
+    }
 }
 
-void W_Local::takt()
+void W_Local::scrollPaO()
 {
-    if(!this->nextLineSignals.empty()){
-        // perform operations selected
-        for (const auto& signal : this->nextLineSignals) {
-            auto it = this->signalMap.find(signal);
-            if (it != this->signalMap.end()) {
-                (this->*(it->second))();
+    EncoderState enc = this->humInter->getEncoderState();
+
+    if(enc != IDLE){
+        if(enc == UP){
+            if(PaORangeLow < (W_Machine::MEMORY_SIZE - PAO_ROWS)) {
+                PaORangeLow++;
+            }
+            else {
+                PaORangeLow  = 0;
             }
         }
-             
-        // turn off all the signal lines after takt is executed
-        for(auto &signal : this->signal){
-            signal.second = false;
+        else if(enc == DOWN){
+            if(PaORangeLow > 0) {
+                PaORangeLow--;
+            }
+            else {
+                PaORangeLow  = (W_Machine::MEMORY_SIZE - PAO_ROWS);
+            }
         }
-
-        this->nextLineSignals.clear();
+        PaOViewChanged = true;
+        // Serial.printf("[W_LOCAL][DEBUG] PaORange %d<->%d\n", PaORangeLow, (PaORangeLow + PAO_ROWS - 1));
     }
 }
 
-void W_Local::refreshDisplay()
+void W_Local::changeClockSpeed()
 {
-    if(this->dispMan){
-        // Three digit displays
-        if(this->dispMan->a)    this->dispMan->a->displayValue(binaryTo_uint8_t(A));
-        if(this->dispMan->acc)  this->dispMan->acc->displayValue(binaryTo_uint8_t(AK));
-        if(this->dispMan->c)    this->dispMan->c->displayValue(binaryTo_uint8_t(L));
-        if(this->dispMan->i)    this->dispMan->i->displayValue(binaryTo_uint8_t(I));
-        if(this->dispMan->s)    this->dispMan->s->displayValue(binaryTo_uint8_t(S));
-        
-        // Turn off all signal lines that are NOT in nextLineSignals
-        for (const auto& sig : this->signal) {
-            if (sig.first == "IL"     && this->dispMan->il)     this->dispMan->il->turnOnLine(sig.second);
-            if (sig.first == "WEL"    && this->dispMan->wel)    this->dispMan->wel->turnOnLine(sig.second);
-            if (sig.first == "WYL"    && this->dispMan->wyl)    this->dispMan->wyl->turnOnLine(sig.second);
-            if (sig.first == "WYAD"   && this->dispMan->wyad1  && this->dispMan->wyad2){
-                                                                    this->dispMan->wyad1->turnOnLine(sig.second); 
-                                                                    this->dispMan->wyad2->turnOnLine(sig.second);}
-            if (sig.first == "WEI"    && this->dispMan->wei)    this->dispMan->wei->turnOnLine(sig.second);
-            if (sig.first == "WEJA"   && this->dispMan->weja)   this->dispMan->weja->turnOnLine(sig.second);
-            if (sig.first == "PRZEP"  && this->dispMan->przep)  this->dispMan->przep->turnOnLine(sig.second); 
-            if (sig.first == "ODE"    && this->dispMan->ode)    this->dispMan->ode->turnOnLine(sig.second);
-            if (sig.first == "DOD"    && this->dispMan->dod)    this->dispMan->dod->turnOnLine(sig.second);  
-            if (sig.first == "WEAK"   && this->dispMan->weak)   this->dispMan->weak->turnOnLine(sig.second);
-            if (sig.first == "WYAK"   && this->dispMan->wyak)   this->dispMan->wyak->turnOnLine(sig.second);
-            if (sig.first == "WEA"    && this->dispMan->wea)    this->dispMan->wea->turnOnLine(sig.second);
-            if (sig.first == "CZYT"   && this->dispMan->czyt)   this->dispMan->czyt->turnOnLine(sig.second); 
-            if (sig.first == "PISZ"   && this->dispMan->pisz)   this->dispMan->pisz->turnOnLine(sig.second);
-            if (sig.first == "WES"    && this->dispMan->wes)    this->dispMan->wes->turnOnLine(sig.second);
-            if (sig.first == "WYS"    && this->dispMan->wys)    this->dispMan->wys->turnOnLine(sig.second);
-        }
-    
+    EncoderState enc = this->humInter->getEncoderState();
+    uint8_t speed = this->sequencer.getSpeed();
 
-        // TODO trzeba zrobić warunek włączenia się ledów stopu
-        if(this->dispMan->stop)   this->dispMan->stop->turnOnLine(false);
+    if(enc == DOWN && speed + 1 < W_Sequencer::SPEED_COUNT){
+        speed++;
+    }
+    else if(enc == UP && speed > 0){
+        speed--;
+    }
+    else {
+        return;
+    }
 
-        //PaO
-        for(int i = 0; i <= 3; i++){
-            if(this->dispMan->pao[i]){
-                static RgbColor tempColor(0, 255, 0);
-                
-                if(binaryTo_uint8_t(A) == i + PaORangeLow){
-                    this->dispMan->pao[i]->setTemporaryColor(tempColor);
-                }
-                else{
-                    this->dispMan->pao[i]->restoreColor();
-                }
-                
-                _3Bit arg;
-                for(int n = 5; n < 8; n++){
-                    arg[n] = PaO[i+PaORangeLow][n];   
-                }
-                this->dispMan->pao[i]->displayLine(i+PaORangeLow, binaryTo_uint8_t(PaO[i+PaORangeLow]), binaryTo_uint8_t(arg));
-            }
-        }
+    this->sequencer.setSpeed(speed);
+    Serial.printf("[W_LOCAL]: Clock %s\n", W_Sequencer::SPEEDS[speed].label);
 
-        //Bus lines
-        this->refreshBUSLines();
-        
-        this->dispMan->refreshDisplay();
+    if(this->sequencer.isTurbo()){
+        this->turboTakts = 0;
+        this->turboReportTime = millis();
     }
 }
 
-void W_Local::refreshBUSLines()
+void W_Local::runTurbo()
 {
+    uint32_t frameStart = micros();
+
+    do {
+        this->turboTakts += this->sequencer.runBurst(TURBO_BURST_STEPS);
+    } while(this->sequencer.isRunning() && micros() - frameStart < TURBO_FRAME_MICROS);
+
     unsigned long now = millis();
-    static unsigned long busATurnOnTime = 0;
-    static unsigned long busSTurnOnTime = 0;
-    
-    if(this->busLED.at("A")){
-        if(this->dispMan->busA) this->dispMan->busA->turnOnLine(true);
-        busATurnOnTime = now; 
-        this->busLED.at("A") = false;
+    unsigned long elapsed = now - this->turboReportTime;
+
+    if(elapsed >= TURBO_REPORT_MILLIS || !this->sequencer.isRunning()){
+        if(elapsed > 0){
+            Serial.printf("[W_LOCAL]: Turbo %lu takts/s\n", (unsigned long)(this->turboTakts * 1000ULL / elapsed));
+        }
+        this->turboTakts = 0;
+        this->turboReportTime = now;
     }
-    if(this->busLED.at("S")){
-        if(this->dispMan->busS) this->dispMan->busS->turnOnLine(true);
-        busSTurnOnTime = now;
-        this->busLED.at("S") = false;
+}
+
+void W_Local::toggleHistoryMode()
+{
+    if(this->sequencer.isRunning()){
+        return;
     }
 
-    if(now - busATurnOnTime >= BUS_LIGHT_UP_MILLIS)
-    {
-        if(this->dispMan->busA) this->dispMan->busA->turnOnLine(false);
+    if(this->historyMode){
+        this->history.seek(this->machine, this->history.getNewest());
+        this->machine.restoreSignals(this->liveSignals);
+        this->historyMode = false;
+        Serial.println("[W_LOCAL]: History mode off");
     }
-    
-    if(now - busSTurnOnTime >= BUS_LIGHT_UP_MILLIS)
-    {
-        if(this->dispMan->busS) this->dispMan->busS->turnOnLine(false);
+    else {
+        this->liveSignals = this->machine.getSelectedSignals();
+        this->historyMode = true;
+        Serial.printf("[W_LOCAL]: History mode on, %lu takts back available\n",
+                      (unsigned long)(this->history.getNewest() - this->history.getOldest()));
     }
 }
 
-void W_Local::readButtonInputs()
+void W_Local::browseHistory()
 {
-    char* button = this->humInter->getPressedButton();
+    EncoderState enc = this->humInter->getEncoderState();
+    bool moved = false;
 
-    if(button != this->lastPressedButton) {
-        if(button != nullptr){
-            std::string buttonStr(button);
+    if(enc == UP){
+        moved = this->history.stepBack(this->machine);
+    }
+    else if(enc == DOWN){
+        moved = this->history.stepForward(this->machine);
+    }
 
-            Serial.println(button);
+    if(moved){
+        this->machine.restoreSignals(this->history.isLive() ? this->liveSignals : this->history.getNextSignals());
+        Serial.printf("[W_LOCAL]: History -%lu\n", (unsigned long)(this->history.getNewest() - this->history.getPosition()));
+    }
+}
 
-            if(buttonStr == "TAKT"){
-                this->takt();
-            }
-            else {
-                auto itSignal = std::find(this->nextLineSignals.begin(), this->nextLineSignals.end(), buttonStr);
-                
-                if(itSignal != this->nextLineSignals.end()){
-                    this->nextLineSignals.erase(itSignal);
-                    
-                    auto it = this->signal.find(buttonStr);
-                    if(it != this->signal.end()){
-                        it->second = false;
-                    }
-                }
-                else{
-                    if(isSignalValid(buttonStr)) {
-                        this->nextLineSignals.push_back(buttonStr);
-                    }
+void W_Local::resumeFromHistory()
+{
+    if(!this->history.isLive()){
+        this->history.truncate();
+        this->sequencer.rewind();
+        Serial.println("[W_LOCAL]: Resumed from history, newer takts discarded");
+    }
+    this->historyMode = false;
+}
 
-                    auto it = this->signal.find(buttonStr);
-                    if(it != this->signal.end()){
-                        it->second = true;
-                    }
-                }
-            }
-        }
+void W_Local::setSignal(Signal signal, bool active)
+{
+    if(this->machine.isSignalActive(signal) == active){
+        return;
+    }
 
-        this->lastPressedButton = button;
+    if(this->historyMode){
+        this->resumeFromHistory();
     }
+    this->pressSignal(signal);
 }
 
-template<size_t N>
-void W_Local::insertMode(std::bitset<N> &selectedRegister)
+void W_Local::setRegister(Register reg, uint32_t value)
 {
-    EncoderState enc = this->humInter->getEncoderState();
-    uint8_t regVal = binaryTo_uint8_t(selectedRegister);
-    uint8_t maxVal = pow(2, N);
+    if(this->machine.getRegister(reg) == value){
+        return;
+    }
 
-    if(enc == DOWN){
-        if(regVal < maxVal) {
-            regVal++;
-        }
-        else {
-            regVal = 0;
-        }
+    if(this->historyMode){
+        this->resumeFromHistory();
     }
-    else if(enc == UP){
-        if(regVal >= 0) {
-            regVal--;
-        }
-        else {
-            regVal = maxVal;
-        } 
+    this->machine.setRegister(reg, value);
+}
+
+void W_Local::setMemory(uint32_t address, uint32_t value)
+{
+    if(this->machine.getMemory(address) == value){
+        return;
     }
 
-    selectedRegister = std::bitset<N>(regVal);
+    if(this->historyMode){
+        this->resumeFromHistory();
+    }
+    this->machine.setMemory(address, value);
 }
 
-void W_Local::scrollPaO()
+void W_Local::redrawPanel()
 {
-    EncoderState enc = this->humInter->getEncoderState();
-
-    if(enc != IDLE){
-        if(enc == UP){
-            if(PaORangeLow < (31 - 3)) {
-                PaORangeLow++;
-            }
-            else {
-                PaORangeLow  = 0;
-            }
-        }
-        else if(enc == DOWN){
-            if(PaORangeLow > 0) {
-                PaORangeLow--;
-            }
-            else {
-                PaORangeLow  = (31 - 3);
-            }
-        }
-        // Serial.printf("[W_LOCAL][DEBUG] PaORange %d<->%d\n", PaORangeLow, (PaORangeLow+3));
+    this->machine.markAllChanged();
+    this->drawnSignals = 0;
+    this->PaORangeHighlight = 0xFF;
+    this->PaOViewChanged = true;
+    this->stopLit = false;
+    for(bool &lit : this->busLit){
+        lit = false;
     }
 }
 
@@ -383,11 +393,11 @@ ThreeDigitDisplay *W_Local::getSelectedDisplay(const Register selectedRegister)
 {
     if (!dispMan) return nullptr;
     
-    if (selectedRegister == regA)  return dispMan->a;
-    if (selectedRegister == regAK) return dispMan->acc;
-    if (selectedRegister == regL)  return dispMan->c;
-    if (selectedRegister == regI)  return dispMan->i;
-    if (selectedRegister == regS)  return dispMan->s;
+    if (selectedRegister == W_Machine::regA)  return dispMan->a;
+    if (selectedRegister == W_Machine::regAK) return dispMan->acc;
+    if (selectedRegister == W_Machine::regL)  return dispMan->c;
+    if (selectedRegister == W_Machine::regI)  return dispMan->i;
+    if (selectedRegister == W_Machine::regS)  return dispMan->s;
     
     return nullptr;
 }
@@ -415,6 +425,11 @@ void W_Local::handleEncoderMode()
             insertModeToggled = true;
 
             suppressNextReleaseClick = true;
+
+            // Editing a state from the history continues from it
+            if(insertModeEnabled && this->historyMode){
+                this->resumeFromHistory();
+            }
             
             Serial.printf("[W_LOCAL][DEBUG] Insert mode toggled: {%d}\n", insertModeEnabled);
         }
@@ -422,7 +437,7 @@ void W_Local::handleEncoderMode()
     else {
         pressStartTime = 0;
         if(insertModeToggled && !insertModeEnabled){
-            display->setColor(dispMan->getElementColor(DisplayElement::DIGIT_DISPLAY));
+            display->setColor(PALETTE_DISPLAY);
         }
         insertModeToggled = false;
     }
@@ -442,7 +457,7 @@ void W_Local::handleEncoderMode()
                 selectedValue = 0;
 
             // Change back color of the previously selected display
-            display->setColor(dispMan->getElementColor(DisplayElement::DIGIT_DISPLAY));
+            display->setColor(PALETTE_DISPLAY);
             
             // Update display pointer for new selection
             display = getSelectedDisplay(static_cast<Register>(selectedValue));
@@ -453,18 +468,93 @@ void W_Local::handleEncoderMode()
 
         dispMan->blinkingAnimation(display, DisplayElement::DIGIT_DISPLAY);        
         
-        // Dispatch: selecting appropriate std::bitset<N> at compile time
-        switch (static_cast<Register>(selectedValue)) {
-            case Register::regA:  insertMode(A);  break; // bitset<5>
-            case Register::regI:  insertMode(I);  break; // bitset<5>
-            case Register::regL:  insertMode(L);  break; // bitset<5>
-            case Register::regAK: insertMode(AK); break; // bitset<8>
-            case Register::regS:  insertMode(S);  break; // bitset<8>
-            default: break;
-        }
+        insertMode(static_cast<Register>(selectedValue));
     }
     else {
-        scrollPaO();
+        if (suppressNextReleaseClick) {
+            if (currentState == HIGH) {
+                suppressNextReleaseClick = false;
+                buttonStateLastFrame = HIGH;
+            }
+        }
+        else if (buttonStateLastFrame == LOW && currentState == HIGH) {
+            toggleHistoryMode();
+        }
+
+        buttonStateLastFrame = currentState;
+
+        if(this->historyMode) {
+            browseHistory();
+        }
+        else if(this->sequencer.isRunning()) {
+            changeClockSpeed();
+        }
+        else {
+            scrollPaO();
+        }
+    }
+}
+
+void W_Local::handleSerialDebug()
+{
+    while(Serial.available() > 0){
+        switch(Serial.read()){
+            case 't':
+                this->traceFollowing = !this->traceFollowing;
+                this->traceDumping = false;
+                this->traceCursor = this->trace.latest(0);
+                Serial.printf("[W_LOCAL]: Trace streaming %s\n", this->traceFollowing ? "on" : "off");
+                break;
+
+            case 'd':
+                this->traceFollowing = false;
+                this->traceDumping = true;
+                this->traceCursor = this->trace.latest(W_Trace::CAPACITY);
+                this->traceDumpEnd = this->trace.getCount();
+                Serial.printf("[W_LOCAL]: Trace dump of %lu takts\n", (unsigned long)(this->traceDumpEnd - this->traceCursor.next));
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    this->streamTrace();
+}
+
+void W_Local::streamTrace()
+{
+    if(!this->traceFollowing && !this->traceDumping){
+        return;
+    }
+
+    size_t max = Serial.availableForWrite() / W_Trace::LINE_SIZE;
+    if(max > TRACE_LINES_PER_LOOP){
+        max = TRACE_LINES_PER_LOOP;
+    }
+    if(this->traceDumping && this->traceDumpEnd - this->traceCursor.next < max){
+        max = this->traceDumpEnd - this->traceCursor.next;
+    }
+
+    TraceEntry entries[TRACE_LINES_PER_LOOP];
+    char line[W_Trace::LINE_SIZE];
+    uint32_t dropped = this->traceCursor.dropped;
+
+    size_t count = this->trace.read(this->traceCursor, entries, max);
+
+    if(this->traceCursor.dropped != dropped){
+        Serial.printf("[W_LOCAL]: Trace dropped %lu takts\n", (unsigned long)(this->traceCursor.dropped - dropped));
+    }
+
+    uint32_t number = this->traceCursor.next - count;
+    for(size_t n = 0; n < count; n++){
+        W_Trace::format(entries[n], number + n, line, sizeof(line));
+        Serial.println(line);
+    }
+
+    if(this->traceDumping && (int32_t)(this->traceCursor.next - this->traceDumpEnd) >= 0){
+        this->traceDumping = false;
+        Serial.println("[W_LOCAL]: Trace dump done");
     }
 }
 
@@ -515,33 +605,20 @@ void W_Local::printValuesToSerial()
     // }
 }
 
-bool W_Local::isSignalValid(const std::string &newSignal)
-{
-    auto conflictIt = signalConflicts.find(newSignal);
-    if (conflictIt == signalConflicts.end()) {
-        return true;
-    }
-
-    const auto& conflicts = conflictIt->second;
-    
-    for (const auto& existingSignal : this->nextLineSignals) {
-        for (const auto& conflictSignal : conflicts) {
-            if (existingSignal == conflictSignal) {
-                Serial.printf("[W_LOCAL][DEBUG]: Signal '%s' conflicts with '%s'\n", 
-                            newSignal.c_str(), conflictSignal.c_str());
-                return false;
-            }
-        }
-    }
-    
-    return true;
-}
-
 void W_Local::runLocal()
 {
+    handleSerialDebug();
+
     readButtonInputs();
 
     handleEncoderMode();
+
+    if(this->sequencer.isRunning() && this->sequencer.isTurbo()){
+        runTurbo();
+    }
+    else {
+        this->sequencer.update(micros());
+    }
     
     refreshDisplay();
     
@@ -0,0 +1,414 @@
+#include "w_machine.h"
+#include "w_history.h"
+
+const W_Machine::CommandFunction W_Machine::COMMANDS[Signals::COUNT] = {
+    &W_Machine::il,     // IL
+    &W_Machine::wel,    // WEL
+    &W_Machine::wyl,    // WYL
+    &W_Machine::wyad,   // WYAD
+    &W_Machine::wei,    // WEI
+    &W_Machine::weak,   // WEAK
+    &W_Machine::dod,    // DOD
+    &W_Machine::ode,    // ODE
+    &W_Machine::przep,  // PRZEP
+    &W_Machine::wyak,   // WYAK
+    &W_Machine::weja,   // WEJA
+    &W_Machine::wea,    // WEA
+    &W_Machine::czyt,   // CZYT
+    &W_Machine::pisz,   // PISZ
+    &W_Machine::wes,    // WES
+    &W_Machine::wys     // WYS
+};
+
+W_Machine::W_Machine()
+{
+    this->reset();
+}
+
+void W_Machine::write(Register target, uint32_t value)
+{
+    Word masked = value & REGISTER_MASK[target];
+
+    if(this->registers[target] != masked){
+        this->registers[target] = masked;
+        this->changes.registers |= 1 << target;
+    }
+}
+
+void W_Machine::drive(Bus target, uint32_t value)
+{
+    this->bus[target] = value & BUS_MASK[target];
+    this->changes.buses |= 1 << target;
+}
+
+void W_Machine::store(uint32_t address, uint32_t value)
+{
+    Word word = value & GEOMETRY.wordMask();
+
+    if(this->PaO[address] != word){
+        this->PaO[address] = word;
+        this->changes.memory.set(address);
+    }
+}
+
+void W_Machine::beginDelta(Delta &delta, uint32_t address) const
+{
+    for(uint8_t reg = 0; reg < REGISTER_COUNT; reg++) delta.registers[reg] = this->registers[reg];
+    for(uint8_t line = 0; line < BUS_COUNT; line++)   delta.bus[line] = this->bus[line];
+
+    delta.address = address;
+    delta.memory = this->PaO[address];
+}
+
+void W_Machine::commitDelta(Delta &delta, SignalMask signals)
+{
+    for(uint8_t reg = 0; reg < REGISTER_COUNT; reg++) delta.registers[reg] ^= this->registers[reg];
+    for(uint8_t line = 0; line < BUS_COUNT; line++)   delta.bus[line] ^= this->bus[line];
+
+    delta.memory ^= this->PaO[delta.address];
+    delta.signals = signals;
+
+    this->history->record(delta, *this);
+}
+
+void W_Machine::reset()
+{
+    for(Word &value : this->registers) value = 0;
+    for(Word &value : this->bus) value = 0;
+    for(Word &word : this->PaO)  word = 0;
+
+    this->selected = 0;
+
+    this->markAllChanged();
+}
+
+void W_Machine::il()
+{
+    this->write(regL, this->registers[regL] + 1);
+}
+
+void W_Machine::wel()
+{
+    this->write(regL, this->bus[BUS_A]);
+}
+
+void W_Machine::wyl()
+{
+    this->drive(BUS_A, this->registers[regL]);
+}
+
+void W_Machine::wyad()
+{
+    this->drive(BUS_A, GEOMETRY.address(this->registers[regI]));
+}
+
+void W_Machine::wei()
+{
+    this->write(regI, this->bus[BUS_S]);
+}
+
+void W_Machine::weak()
+{
+    this->write(regAK, this->registers[regJAML]);
+}
+
+void W_Machine::dod()
+{
+    this->write(regAK, this->registers[regAK] + this->registers[regJAML]);
+}
+
+void W_Machine::ode()
+{
+    this->write(regAK, this->registers[regAK] - this->registers[regJAML]);
+}
+
+void W_Machine::przep()
+{
+    this->write(regAK, this->bus[BUS_S]);
+}
+
+void W_Machine::wyak()
+{
+    this->drive(BUS_S, this->registers[regAK]);
+}
+
+void W_Machine::weja()
+{
+    this->write(regJAML, this->bus[BUS_S]);
+}
+
+void W_Machine::wea()
+{
+    this->write(regA, this->bus[BUS_A]);
+}
+
+void W_Machine::czyt()
+{
+    this->write(regS, this->PaO[this->registers[regA]]);
+}
+
+void W_Machine::pisz()
+{
+    this->store(this->registers[regA], this->registers[regS]);
+}
+
+void W_Machine::wes()
+{
+    this->write(regS, this->bus[BUS_S]);
+}
+
+void W_Machine::wys()
+{
+    this->drive(BUS_S, this->registers[regS]);
+}
+
+uint8_t W_Machine::scheduleSlot(SignalMask signals)
+{
+    return (signals ^ (signals >> 5) ^ (signals >> 11)) & (SCHEDULE_CACHE_SIZE - 1);
+}
+
+const W_Machine::Schedule& W_Machine::scheduleOf(SignalMask signals)
+{
+    Schedule &schedule = this->schedules[scheduleSlot(signals)];
+
+    if(schedule.signals != signals || schedule.count == 0){
+        schedule.signals = signals;
+        schedule.count = 0;
+        for(Signal signal : Signals::EXECUTION_ORDER.signals){
+            if(signals & Signals::bit(signal)){
+                schedule.order[schedule.count++] = signal;
+            }
+        }
+    }
+
+    return schedule;
+}
+
+void W_Machine::takt()
+{
+    if(this->selected){
+        TraceEntry entry;
+        Delta delta;
+        uint8_t changedRegisters = this->changes.registers;
+        uint8_t drivenBuses = this->changes.buses;
+
+        if(this->trace){
+            // Collect the changes of this TAKT alone, merged back below
+            this->changes.registers = 0;
+            this->changes.buses = 0;
+
+            // PISZ acts before the latches, so it writes the S and A of the TAKT start
+            if(this->selected & Signals::bit(Signal::PISZ)){
+                entry.flags |= TraceEntry::MEMORY_WRITTEN;
+                entry.address = GEOMETRY.address(this->registers[regA]);
+                entry.value = this->registers[regS];
+            }
+        }
+
+        if(this->history){
+            // PISZ is the only signal writing memory, at the A of the TAKT start
+            this->beginDelta(delta, this->registers[regA]);
+        }
+
+        // perform operations selected, phase by phase
+        const Schedule &schedule = this->scheduleOf(this->selected);
+        for(uint8_t n = 0; n < schedule.count; n++){
+            (this->*COMMANDS[static_cast<uint8_t>(schedule.order[n])])();
+        }
+
+        if(this->trace){
+            entry.signals = this->selected;
+            entry.registers = this->changes.registers;
+            entry.flags |= this->changes.buses << TraceEntry::BUSES_SHIFT;
+            this->trace->record(entry);
+
+            this->changes.registers |= changedRegisters;
+            this->changes.buses |= drivenBuses;
+        }
+
+        if(this->history){
+            this->commitDelta(delta, this->selected);
+        }
+
+        // turn off all the signal lines after takt is executed
+        this->selected = 0;
+        this->changes.signals = true;
+    }
+}
+
+bool W_Machine::toggleSignal(Signal signal, Signal *conflict)
+{
+    if(signal >= Signal::COUNT){
+        return true;
+    }
+
+    SignalMask bit = Signals::bit(signal);
+
+    if(this->selected & bit){
+        this->selected &= ~bit;
+    }
+    else if(this->isSignalValid(signal, conflict)){
+        this->selected |= bit;
+    }
+    else {
+        return false;
+    }
+
+    this->changes.signals = true;
+    return true;
+}
+
+bool W_Machine::isSignalValid(Signal signal, Signal *conflict) const
+{
+    SignalMask clash = Signals::CONFLICTS[static_cast<uint8_t>(signal)] & this->selected;
+
+    if(clash && conflict){
+        *conflict = static_cast<Signal>(__builtin_ctz(clash));
+    }
+
+    return clash == 0;
+}
+
+void W_Machine::loadSignals(SignalMask signals, const Signal *order, uint8_t count)
+{
+    Schedule &schedule = this->schedules[scheduleSlot(signals)];
+
+    schedule.signals = signals;
+    schedule.count = count;
+    for(uint8_t n = 0; n < count; n++){
+        schedule.order[n] = order[n];
+    }
+
+    this->selected = signals;
+    this->changes.signals = true;
+}
+
+void W_Machine::clearSignals()
+{
+    if(this->selected){
+        this->selected = 0;
+        this->changes.signals = true;
+    }
+}
+
+bool W_Machine::isSignalActive(Signal signal) const
+{
+    return (signal < Signal::COUNT) && (this->selected & Signals::bit(signal));
+}
+
+SignalMask W_Machine::getSelectedSignals() const
+{
+    return this->selected;
+}
+
+W_Machine::Word W_Machine::getRegister(Register reg) const
+{
+    return (reg < REGISTER_COUNT) ? this->registers[reg] : 0;
+}
+
+void W_Machine::setRegister(Register reg, uint32_t value)
+{
+    if(reg < REGISTER_COUNT){
+        if(this->history){
+            Delta delta;
+            this->beginDelta(delta, 0);
+            this->write(reg, value);
+            this->commitDelta(delta, 0);
+        }
+        else {
+            this->write(reg, value);
+        }
+    }
+}
+
+W_Machine::Word W_Machine::getMemory(uint32_t address) const
+{
+    return this->PaO[address & GEOMETRY.addressMask()];
+}
+
+void W_Machine::setMemory(uint32_t address, uint32_t value)
+{
+    address &= GEOMETRY.addressMask();
+
+    if(this->history){
+        Delta delta;
+        this->beginDelta(delta, address);
+        this->store(address, value);
+        this->commitDelta(delta, 0);
+    }
+    else {
+        this->store(address, value);
+    }
+}
+
+void W_Machine::saveState(State &state) const
+{
+    for(uint8_t reg = 0; reg < REGISTER_COUNT; reg++) state.registers[reg] = this->registers[reg];
+    for(uint8_t line = 0; line < BUS_COUNT; line++)   state.bus[line] = this->bus[line];
+    for(uint32_t address = 0; address < MEMORY_SIZE; address++) state.memory[address] = this->PaO[address];
+}
+
+void W_Machine::loadState(const State &state)
+{
+    for(uint8_t reg = 0; reg < REGISTER_COUNT; reg++){
+        this->write(static_cast<Register>(reg), state.registers[reg]);
+    }
+    for(uint8_t line = 0; line < BUS_COUNT; line++){
+        if(this->bus[line] != state.bus[line]) this->drive(static_cast<Bus>(line), state.bus[line]);
+    }
+    for(uint32_t address = 0; address < MEMORY_SIZE; address++){
+        this->store(address, state.memory[address]);
+    }
+}
+
+void W_Machine::applyDelta(const Delta &delta)
+{
+    for(uint8_t reg = 0; reg < REGISTER_COUNT; reg++){
+        if(delta.registers[reg]){
+            this->registers[reg] ^= delta.registers[reg];
+            this->changes.registers |= 1 << reg;
+        }
+    }
+    for(uint8_t line = 0; line < BUS_COUNT; line++){
+        if(delta.bus[line]){
+            this->bus[line] ^= delta.bus[line];
+            this->changes.buses |= 1 << line;
+        }
+    }
+    if(delta.memory){
+        this->PaO[delta.address] ^= delta.memory;
+        this->changes.memory.set(delta.address);
+    }
+}
+
+void W_Machine::restoreSignals(SignalMask signals)
+{
+    if(this->selected != signals){
+        this->selected = signals;
+        this->changes.signals = true;
+    }
+}
+
+MachineChanges W_Machine::takeChanges()
+{
+    MachineChanges taken = this->changes;
+    this->changes = MachineChanges();
+    return taken;
+}
+
+void W_Machine::attachTrace(W_Trace *trace)
+{
+    this->trace = trace;
+}
+
+void W_Machine::attachHistory(W_History *history)
+{
+    this->history = history;
+}
+
+void W_Machine::markAllChanged()
+{
+    this->changes.registers = (1 << REGISTER_COUNT) - 1;
+    this->changes.memory.set();
+    this->changes.signals   = true;
+}
@@ -0,0 +1,115 @@
+#include "w_protocol.h"
+
+namespace Protocol {
+    namespace {
+        void readRows(Reader &reader, PaORows &rows)
+        {
+            rows.first = reader.u8();
+            rows.count = reader.u8();
+            if (rows.count > PAO_ROWS || rows.first + rows.count > PAO_ROWS) {
+                rows.count = 0;
+                reader.fail();
+                return;
+            }
+            for (uint8_t n = 0; n < rows.count; n++) {
+                rows.rows[n].address  = reader.u16();
+                rows.rows[n].argument = reader.u16();
+                rows.rows[n].value    = reader.u16();
+            }
+        }
+
+        void writePanel(Writer &writer, const Panel &panel)
+        {
+            writer.u8(static_cast<uint8_t>(panel.encoder));
+            writer.u8(panel.count);
+            for (uint8_t n = 0; n < panel.count && n < PANEL_BUTTONS; n++) {
+                writer.u8(static_cast<uint8_t>(panel.buttons[n]));
+            }
+        }
+    }
+
+    bool peekOpcode(const uint8_t *data, size_t size, Opcode &opcode)
+    {
+        if (size == 0) {
+            return false;
+        }
+        opcode = static_cast<Opcode>(data[0]);
+        return true;
+    }
+
+    bool decodeHello(Reader &reader, uint8_t &version)
+    {
+        version = reader.u8();
+        return reader.isOk() && version > 0;
+    }
+
+    bool decodeField(Reader &reader, Field &field, uint16_t &value)
+    {
+        field = static_cast<Field>(reader.u8());
+        value = reader.u16();
+        return reader.isOk() && (isSignal(field) || isRegister(field) ||
+                                 field == Field::BUS_A || field == Field::BUS_S || field == Field::STOP);
+    }
+
+    bool decodePaORows(Reader &reader, PaORows &rows)
+    {
+        readRows(reader, rows);
+        return reader.isOk();
+    }
+
+    bool decodeState(Reader &reader, State &state)
+    {
+        for (uint16_t &value : state.registers) {
+            value = reader.u16();
+        }
+        state.signals = reader.u16();
+        state.lines = reader.u8();
+        readRows(reader, state.pao);
+        return reader.isOk();
+    }
+
+    bool decodeMemory(Reader &reader, Memory &memory)
+    {
+        memory.first = reader.u16();
+        memory.count = reader.u16();
+        memory.words = reader.bytes(2 * static_cast<size_t>(memory.count));
+        return reader.isOk();
+    }
+
+    size_t encodeHello(uint8_t *buffer, size_t size, uint8_t version)
+    {
+        Writer writer(buffer, size);
+        writer.u8(static_cast<uint8_t>(Opcode::HELLO));
+        writer.u8(version);
+        return writer.length();
+    }
+
+    size_t encodePanel(uint8_t *buffer, size_t size, const Panel &panel)
+    {
+        Writer writer(buffer, size);
+        writer.u8(static_cast<uint8_t>(Opcode::PANEL));
+        writePanel(writer, panel);
+        return writer.length();
+    }
+
+    size_t encodeDiff(uint8_t *buffer, size_t size, const Diff &diff)
+    {
+        Writer writer(buffer, size);
+        writer.u8(static_cast<uint8_t>(Opcode::DIFF));
+        writer.u8(diff.registers);
+        for (uint8_t n = 0; n < DIFF_REGISTERS; n++) {
+            if (diff.registers & (1 << n)) {
+                writer.u16(diff.values[n]);
+            }
+        }
+        writer.u16(diff.signals);
+        writer.u8(diff.lines);
+        writer.u8(diff.count);
+        for (uint8_t n = 0; n < diff.count && n < DIFF_CELLS; n++) {
+            writer.u16(diff.cells[n].address);
+            writer.u16(diff.cells[n].word);
+        }
+        writePanel(writer, diff.panel);
+        return writer.length();
+    }
+}
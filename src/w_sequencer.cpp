@@ -0,0 +1,177 @@
+#include "w_sequencer.h"
+
+W_Sequencer::W_Sequencer(W_Machine &machine) : machine(machine)
+{
+    for(uint32_t opcode = 0; opcode < Microprogram::INSTRUCTION_COUNT && opcode < OPCODE_COUNT; opcode++){
+        this->instructions[opcode] = Microprogram::compile(Microprogram::INSTRUCTIONS[opcode]);
+    }
+}
+
+bool W_Sequencer::setInstruction(uint32_t opcode, const Microprogram::Instruction &source)
+{
+    if(opcode >= OPCODE_COUNT || source.stepCount > Microprogram::MAX_EXECUTE_STEPS || !Microprogram::isConflictFree(source)){
+        return false;
+    }
+
+    this->instructions[opcode] = Microprogram::compile(source);
+    return true;
+}
+
+bool W_Sequencer::isStepEnabled(const Microprogram::CompiledStep &executeStep) const
+{
+    using Microprogram::Condition;
+
+    bool negative = (this->machine.getRegister(W_Machine::regAK) >> (W_Machine::GEOMETRY.wordBits - 1)) & 1;
+
+    switch(executeStep.condition){
+        case Condition::AK_NEGATIVE:     return negative;
+        case Condition::AK_NOT_NEGATIVE: return !negative;
+        default:                         return true;
+    }
+}
+
+void W_Sequencer::advance()
+{
+    if(this->step == FETCH_STEP){
+        // Register I now holds the fetched word
+        uint32_t opcode = W_Machine::GEOMETRY.opcode(this->machine.getRegister(W_Machine::regI));
+        this->instruction = &this->instructions[opcode];
+        this->step = 0;
+    }
+    else {
+        this->step++;
+    }
+
+    while(this->instruction && this->step < this->instruction->stepCount &&
+          !this->isStepEnabled(this->instruction->steps[this->step])){
+        this->step++;
+    }
+
+    if(!this->instruction || this->instruction->stepCount == 0){
+        // STP or an unknown instruction code
+        this->halted  = true;
+        this->running = false;
+        this->instruction = nullptr;
+        this->step = FETCH_STEP;
+    }
+    else if(this->step >= this->instruction->stepCount){
+        this->instruction = nullptr;
+        this->step = FETCH_STEP;
+    }
+}
+
+void W_Sequencer::selectStep()
+{
+    const Microprogram::CompiledStep &current = this->instruction ? this->instruction->steps[this->step]
+                                                                  : Microprogram::COMPILED_FETCH;
+
+    this->machine.loadSignals(current.signals, current.order, current.count);
+    this->stepSelected = true;
+}
+
+void W_Sequencer::start(uint32_t nowMicros)
+{
+    if(this->halted){
+        this->halted = false;
+        this->instruction = nullptr;
+        this->step = FETCH_STEP;
+    }
+
+    this->selectStep();
+    this->running = true;
+    this->lastTickMicros = nowMicros;
+}
+
+void W_Sequencer::stop()
+{
+    if(this->stepSelected){
+        this->machine.clearSignals();
+        this->stepSelected = false;
+    }
+    this->running = false;
+}
+
+void W_Sequencer::rewind()
+{
+    this->halted = false;
+    this->instruction = nullptr;
+    this->step = FETCH_STEP;
+}
+
+bool W_Sequencer::tick()
+{
+    if(this->halted){
+        return false;
+    }
+
+    if(!this->stepSelected){
+        this->selectStep();
+    }
+
+    this->machine.takt();
+    this->stepSelected = false;
+
+    this->advance();
+    if(this->halted){
+        return false;
+    }
+
+    this->selectStep();
+    return true;
+}
+
+void W_Sequencer::update(uint32_t nowMicros)
+{
+    if(!this->running || this->isTurbo()){
+        return;
+    }
+
+    uint32_t period = SPEEDS[this->speed].periodMicros;
+
+    if(period == 0 || nowMicros - this->lastTickMicros >= period){
+        this->lastTickMicros = nowMicros;
+        this->tick();
+    }
+}
+
+uint32_t W_Sequencer::runBurst(uint32_t maxSteps)
+{
+    uint32_t executed = 0;
+
+    while(this->running && executed < maxSteps){
+        this->tick();
+        executed++;
+    }
+
+    return executed;
+}
+
+bool W_Sequencer::isRunning() const
+{
+    return this->running;
+}
+
+bool W_Sequencer::isHalted() const
+{
+    return this->halted;
+}
+
+void W_Sequencer::setSpeed(uint8_t index)
+{
+    this->speed = (index < SPEED_COUNT) ? index : SPEED_COUNT - 1;
+}
+
+uint8_t W_Sequencer::getSpeed() const
+{
+    return this->speed;
+}
+
+bool W_Sequencer::isTurbo() const
+{
+    return this->speed == TURBO_SPEED;
+}
+
+const char* W_Sequencer::getInstructionName() const
+{
+    return this->instruction ? this->instruction->name : "";
+}
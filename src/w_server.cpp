@@ -8,7 +8,10 @@ W_Server::W_Server(DisplayManager *dispMan, HumanInterface *humInter, FileSystem
     dnsServer(new DNSServer()),
     dispMan(dispMan),
     humInter(humInter),
-    fileSystem(fileSystem)
+    fileSystem(fileSystem),
+    local(dispMan, humInter),
+    machineMutex(xSemaphoreCreateMutex()),
+    clientMutex(xSemaphoreCreateMutex())
 {
     this->localURL  = "http://" + LOCAL_IP.toString();
 
@@ -43,6 +46,9 @@ W_Server::~W_Server()
     
     Serial.println("[W_SERVER]: Destructor: DNS deleted");
     delete dnsServer;
+
+    vSemaphoreDelete(machineMutex);
+    vSemaphoreDelete(clientMutex);
     
     dispMan    = nullptr;
     humInter   = nullptr;
@@ -53,6 +59,8 @@ W_Server::~W_Server()
     server     = nullptr;
     ws         = nullptr;
     dnsServer  = nullptr;
+    machineMutex = nullptr;
+    clientMutex  = nullptr;
     
     this->humInter->controlOnboardLED(TOP, LOW);
 
@@ -129,15 +137,23 @@ void W_Server::onEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, Aws
         case WS_EVT_CONNECT:
             Serial.print("[W_SERVER]: ");
             Serial.printf("WebSocket client #%u connected from %s\n", client->id(), client->remoteIP().toString().c_str());
+            if(!this->openSession(client->id())){
+                client->close();
+            }
             break;
 
         case WS_EVT_DISCONNECT:
             Serial.print("[W_SERVER]: ");
             Serial.printf("WebSocket client #%u disconnected\n", client->id());
+
+            // The client is freed after this event; wait until publishUpdates() is done with it
+            xSemaphoreTake(this->clientMutex, portMAX_DELAY);
+            this->closeSession(client->id());
+            xSemaphoreGive(this->clientMutex);
             break;
 
         case WS_EVT_DATA:
-            this->handleWebSocketMessage(arg, data, len);
+            this->handleWebSocketMessage(client, arg, data, len);
             break;
 
         case WS_EVT_PONG:
@@ -150,261 +166,680 @@ void W_Server::onEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, Aws
 }
 
 
-void W_Server::handleWebSocketMessage(void *arg, uint8_t *data, size_t len) {
+W_Server::ClientSession* W_Server::sessionOf(uint32_t id)
+{
+    for(ClientSession &session : this->sessions){
+        if(session.id == id) return &session;
+    }
+    return nullptr;
+}
+
+
+bool W_Server::openSession(uint32_t id)
+{
+    xSemaphoreTake(this->machineMutex, portMAX_DELAY);
+
+    ClientSession *session = this->sessionOf(0);
+
+    if(!session){
+        xSemaphoreGive(this->machineMutex);
+        Serial.printf("[W_SERVER][ERROR]: No session left for WebSocket client #%u\n", id);
+        return false;
+    }
+
+    session->id = id;
+    session->version = 0;
+
+    // A new client is sent the whole machine first
+    session->pending = MachineChanges();
+    session->pending.registers = (1 << W_Machine::REGISTER_COUNT) - 1;
+    session->pending.signals = true;
+    session->pending.memory.set();
+    session->shownSignals = 0;
+    session->panel = Protocol::Panel();
+
+    session->received = 0;
+    session->overflowed = false;
+    session->sent = 0;
+    session->dropped = 0;
+    session->reportedDropped = 0;
+    session->queueDepth = 0;
+    session->maxQueueDepth = 0;
+
+    xSemaphoreGive(this->machineMutex);
+    return true;
+}
+
+
+void W_Server::closeSession(uint32_t id)
+{
+    xSemaphoreTake(this->machineMutex, portMAX_DELAY);
+
+    ClientSession *session = this->sessionOf(id);
+
+    if(session){
+        // The reassembly buffer is left as it is, the next session resets received
+        session->id = 0;
+        session->version = 0;
+        session->received = 0;
+        session->overflowed = false;
+    }
+
+    xSemaphoreGive(this->machineMutex);
+}
+
+
+void W_Server::handleWebSocketMessage(AsyncWebSocketClient *client, void *arg, uint8_t *data, size_t len) {
     AwsFrameInfo *info = (AwsFrameInfo*)arg;
-    if (info->final && info->index == 0 && info->len == len && info->opcode == WS_TEXT) {
-        data[len] = 0;
-        
-        StaticJsonDocument<512> doc;
-        DeserializationError error = deserializeJson(doc, (char*)data);
 
-        if(error){
-            Serial.println("[W_SERVER][ERROR]: Failed to deserialize JSON!");
+    // Continuation frames carry the opcode of the message in message_opcode
+    bool firstFrame = info->opcode != WS_CONTINUATION;
+    uint8_t opcode = firstFrame ? info->opcode : info->message_opcode;
+
+    // Whole message in one event, nothing to reassemble
+    if (firstFrame && info->final && info->index == 0 && info->len == len) {
+        this->dispatchMessage(client, opcode, data, len);
+        return;
+    }
+
+    ClientSession *session = this->sessionOf(client->id());
+    if (!session) {
+        return;
+    }
+
+    if (firstFrame && info->index == 0) {
+        session->opcode = opcode;
+        session->received = 0;
+        session->overflowed = false;
+    }
+
+    if (!session->overflowed) {
+        if (session->received + len > W_WS_MESSAGE_MAX) {
+            session->overflowed = true;
+            Serial.printf("[W_SERVER][ERROR]: Message of client #%u exceeds %u bytes, dropped\n",
+                          client->id(), (unsigned)W_WS_MESSAGE_MAX);
+        }
+        else {
+            memcpy(session->message + session->received, data, len);
+            session->received += len;
+        }
+    }
+
+    // Last segment of the last frame
+    if (info->final && info->index + len == info->len) {
+        if (!session->overflowed) {
+            this->dispatchMessage(client, session->opcode, session->message, session->received);
+        }
+        session->received = 0;
+        session->overflowed = false;
+    }
+}
+
+
+void W_Server::dispatchMessage(AsyncWebSocketClient *client, uint8_t opcode, const uint8_t *data, size_t len)
+{
+    if (opcode == WS_BINARY) {
+        this->handleBinaryMessage(client, data, len);
+    }
+    else if (opcode == WS_TEXT) {
+        this->handleJsonMessage(data, len);
+    }
+}
+
+
+void W_Server::handleJsonMessage(const uint8_t *data, size_t len)
+{
+    // The document takes its memory from jsonArena, so parsing does not allocate
+    this->jsonArena.reset();
+    JsonDocument doc(&this->jsonArena);
+    DeserializationError error = deserializeJson(doc, (const char*)data, len);
+
+    if(error){
+        Serial.printf("[W_SERVER][ERROR]: Failed to deserialize JSON: %s\n", error.c_str());
+        return;
+    }
+    
+    // Check for message type
+    const char *type = doc["type"] | "";
+
+    if (strcmp(type, "reg-update") == 0) {
+        xSemaphoreTake(this->machineMutex, portMAX_DELAY);
+        this->processPartialWebSocketData(doc);
+        xSemaphoreGive(this->machineMutex);
+    }
+    else if (strcmp(type, "mem-update") == 0) {
+        xSemaphoreTake(this->machineMutex, portMAX_DELAY);
+        this->processFullWebSocketData(doc);
+        xSemaphoreGive(this->machineMutex);
+    }
+    else if (strcmp(type, "signal-toggle") == 0) {
+        // Lowercase names only; the web app echoes "button_press" under the uppercase name
+        Protocol::Field field;
+        if(Protocol::fieldByName(doc["signal"] | "", field) && Protocol::isSignal(field)){
+            xSemaphoreTake(this->machineMutex, portMAX_DELAY);
+            this->stageField(field, doc["state"] | false);
+            xSemaphoreGive(this->machineMutex);
+        }
+    }
+    else if (strcmp(type, "color-update") == 0) {
+        Serial.println("[W_SERVER]: Color Update Received");
+        this->updateColors(doc);
+    }
+    else if (strcmp(type, "ping") == 0){
+        Serial.println("[W_SERVER]: WebSocket Connection Active");
+    }
+    else {
+        Serial.printf("[W_SERVER][ERROR]: Invalid message type: {%s}\n", type);
+    }
+}
+
+
+void W_Server::handleBinaryMessage(AsyncWebSocketClient *client, const uint8_t *data, size_t len)
+{
+    using namespace Protocol;
+
+    Opcode opcode;
+    if(!peekOpcode(data, len, opcode)){
+        return;
+    }
+
+    Reader reader(data + 1, len - 1);
+
+    switch(opcode){
+        case Opcode::HELLO: {
+            uint8_t version = 0;
+            if(!decodeHello(reader, version)){
+                break;
+            }
+            version = (version < VERSION) ? version : VERSION;
+
+            xSemaphoreTake(this->machineMutex, portMAX_DELAY);
+            ClientSession *session = this->sessionOf(client->id());
+            if(session) session->version = version;
+            xSemaphoreGive(this->machineMutex);
+
+            if(session){
+                uint8_t frame[2];
+                size_t frameLen = encodeHello(frame, sizeof(frame), version);
+                client->binary(frame, frameLen);
+                Serial.printf("[W_SERVER]: Client #%u uses binary protocol v%u\n", client->id(), version);
+            }
+            break;
+        }
+
+        case Opcode::FIELD: {
+            Field field;
+            uint16_t value;
+            if(decodeField(reader, field, value)){
+                xSemaphoreTake(this->machineMutex, portMAX_DELAY);
+                this->stageField(field, value);
+                xSemaphoreGive(this->machineMutex);
+            }
+            break;
+        }
+
+        case Opcode::PAO_ROWS: {
+            PaORows rows;
+            if(decodePaORows(reader, rows)){
+                xSemaphoreTake(this->machineMutex, portMAX_DELAY);
+                this->stagePaORows(rows);
+                xSemaphoreGive(this->machineMutex);
+            }
+            break;
+        }
+
+        case Opcode::STATE: {
+            State state;
+            if(decodeState(reader, state)){
+                xSemaphoreTake(this->machineMutex, portMAX_DELAY);
+                this->stageState(state);
+                xSemaphoreGive(this->machineMutex);
+            }
+            break;
+        }
+
+        case Opcode::MEMORY: {
+            Memory memory;
+            if(decodeMemory(reader, memory)){
+                xSemaphoreTake(this->machineMutex, portMAX_DELAY);
+                this->stageMemory(memory);
+                xSemaphoreGive(this->machineMutex);
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+
+void W_Server::stageSignal(Signal signal, bool active)
+{
+    SignalMask bit = Signals::bit(signal);
+
+    if(active){
+        this->edits.select |= bit;
+        this->edits.deselect &= ~bit;
+    }
+    else {
+        this->edits.deselect |= bit;
+        this->edits.select &= ~bit;
+    }
+}
+
+
+void W_Server::stageRegister(W_Machine::Register reg, uint16_t value)
+{
+    this->edits.registers |= 1 << reg;
+    this->edits.values[reg] = value;
+}
+
+
+void W_Server::stageWord(uint32_t address, uint16_t word)
+{
+    // Addresses wrap around the memory size, as in the machine
+    address &= W_Machine::MEMORY_SIZE - 1;
+
+    this->edits.memory.set(address);
+    this->edits.words[address] = word;
+}
+
+
+void W_Server::stageField(Protocol::Field field, uint16_t value)
+{
+    if(Protocol::isSignal(field)){
+        this->stageSignal(static_cast<Signal>(field), value != 0);
+    }
+    else if(Protocol::isRegister(field)){
+        uint8_t n = static_cast<uint8_t>(field) - static_cast<uint8_t>(Protocol::Field::AK);
+        this->stageRegister(FIELD_REGISTERS[n], value);
+    }
+}
+
+
+void W_Server::stagePaORows(const Protocol::PaORows &rows)
+{
+    for(uint8_t n = 0; n < rows.count; n++){
+        this->stageWord(rows.rows[n].address, rows.rows[n].value);
+    }
+}
+
+
+void W_Server::stageState(const Protocol::State &state)
+{
+    using Protocol::Field;
+
+    for(uint8_t n = 0; n < Protocol::REGISTER_FIELDS; n++){
+        this->stageField(static_cast<Field>(static_cast<uint8_t>(Field::AK) + n), state.registers[n]);
+    }
+    for(uint8_t n = 0; n < Signals::COUNT; n++){
+        this->stageSignal(static_cast<Signal>(n), state.signals & (1u << n));
+    }
+
+    this->stagePaORows(state.pao);
+}
+
+
+void W_Server::stageMemory(const Protocol::Memory &memory)
+{
+    for(uint16_t n = 0; n < memory.count; n++){
+        this->stageWord(memory.first + n, memory.word(n));
+    }
+}
+
+
+void W_Server::applyEdits()
+{
+    if(!this->edits.any()){
+        return;
+    }
+
+    for(uint8_t reg = 0; reg < W_Machine::REGISTER_COUNT; reg++){
+        if(this->edits.registers & (1 << reg)){
+            this->local.setRegister(static_cast<W_Machine::Register>(reg), this->edits.values[reg]);
+        }
+    }
+
+    // Deselect first, a new signal may conflict with one it replaces
+    for(SignalMask bits = this->edits.deselect; bits; bits &= bits - 1){
+        this->local.setSignal(static_cast<Signal>(__builtin_ctz(bits)), false);
+    }
+    for(SignalMask bits = this->edits.select; bits; bits &= bits - 1){
+        this->local.setSignal(static_cast<Signal>(__builtin_ctz(bits)), true);
+    }
+
+    if(this->edits.memory.any()){
+        for(uint32_t address = 0; address < W_Machine::MEMORY_SIZE; address++){
+            if(this->edits.memory.test(address)){
+                this->local.setMemory(address, this->edits.words[address]);
+            }
+        }
+    }
+
+    this->edits.registers = 0;
+    this->edits.select = 0;
+    this->edits.deselect = 0;
+    this->edits.memory.reset();
+}
+
+
+bool W_Server::readPaORows(JsonObjectConst source, Protocol::PaORows &rows)
+{
+    JsonArrayConst addrs = source["addrs"];
+    JsonArrayConst args  = source["args"];
+    JsonArrayConst vals  = source["vals"];
+
+    if(addrs.isNull() || args.isNull() || vals.isNull()){
+        return false;
+    }
+
+    rows.first = 0;
+    rows.count = Protocol::PAO_ROWS;
+    for(uint8_t n = 0; n < Protocol::PAO_ROWS; n++){
+        rows.rows[n].address  = addrs[n] | 0;
+        rows.rows[n].argument = args[n] | 0;
+        rows.rows[n].value    = vals[n] | 0;
+    }
+    return true;
+}
+
+
+void W_Server::processPartialWebSocketData(const JsonDocument &doc) {
+    const char *name = doc["field"] | "";
+
+    // Signal lines send bool, displays send int
+    JsonVariantConst value = doc["value"];
+    uint16_t intValue = value.is<bool>() ? value.as<bool>() : value.as<int>();
+
+    Protocol::Field field;
+    Protocol::PaORows rows;
+
+    if(Protocol::fieldByName(name, field)){
+        this->stageField(field, intValue);
+    }
+    else if(strcmp(name, "addrs") == 0 && this->readPaORows(doc.as<JsonObjectConst>(), rows)){
+        this->stagePaORows(rows);
+    }
+}
+
+
+void W_Server::processFullWebSocketData(const JsonDocument &doc)
+{
+    JsonObjectConst dataObj = doc["data"];
+
+    // Only the register displays are sent in a full update
+    for(const Protocol::FieldName &entry : Protocol::JSON_FIELDS){
+        if(Protocol::isRegister(entry.field)){
+            JsonVariantConst value = dataObj[entry.name];
+            if(!value.isNull()) this->stageField(entry.field, value.as<int>());
+        }
+    }
+
+    Protocol::PaORows rows;
+    if(this->readPaORows(dataObj, rows)){
+        this->stagePaORows(rows);
+    }
+}
+
+
+void W_Server::runMachine()
+{
+    if(this->showingIP){
+        if(millis() - this->ipShownTime < IP_SHOW_MILLIS && !this->humInter->getPressedButton()){
             return;
         }
-        
-        // Check for message type
-        String type = doc["type"] | "";
+        this->showingIP = false;
+        this->local.redrawPanel();
+    }
 
-        if (type == "reg-update") {
-            this->processPartialWebSocketData(doc);
+    xSemaphoreTake(this->machineMutex, portMAX_DELAY);
+    this->applyEdits();
+    xSemaphoreGive(this->machineMutex);
+
+    // Only the loop touches the machine, so it runs (and turbo bursts) without the lock
+    this->local.runLocal();
+
+    const MachineChanges &changes = this->local.getLastChanges();
+    if(changes.any()){
+        xSemaphoreTake(this->machineMutex, portMAX_DELAY);
+        for(ClientSession &session : this->sessions){
+            if(session.id) session.pending.merge(changes);
         }
-        else if (type == "mem-update") {
-            this->processFullWebSocketData(doc);
+        xSemaphoreGive(this->machineMutex);
+    }
+}
+
+
+void W_Server::publishUpdates()
+{
+    unsigned long now = millis();
+    if(now - this->lastPublishTime < PUBLISH_PERIOD_MILLIS){
+        return;
+    }
+    this->lastPublishTime = now;
+
+    uint8_t frame[Protocol::DIFF_SIZE];
+    char json[UPDATE_JSON_SIZE];
+
+    // A client is freed after its WS_EVT_DISCONNECT, which waits for clientMutex
+    xSemaphoreTake(this->clientMutex, portMAX_DELAY);
+
+    for(ClientSession &session : this->sessions){
+        xSemaphoreTake(this->machineMutex, portMAX_DELAY);
+        uint32_t id = session.id;
+        uint8_t version = session.version;
+        if(id){
+            session.panel.merge(this->outbox);
         }
-        else if (type == "color-update") {
-            Serial.println("[W_SERVER]: Color Update Received");
-            this->updateColors(doc);
+        xSemaphoreGive(this->machineMutex);
+
+        AsyncWebSocketClient *client = id ? this->ws->client(id) : nullptr;
+        if(!client) continue;
+
+        uint16_t queueDepth = client->queueLen();
+        bool full = client->queueIsFull() || !client->canSend();
+
+        // Only the session is read under the lock, the client is called without it
+        Protocol::Diff diff;
+        SignalMask toggled = 0;
+        bool send = false;
+
+        xSemaphoreTake(this->machineMutex, portMAX_DELAY);
+        if(session.id == id){
+            session.queueDepth = queueDepth;
+            if(queueDepth > session.maxQueueDepth){
+                session.maxQueueDepth = queueDepth;
+            }
+
+            // Version 1 clients only get the panel input
+            bool changed = !session.panel.isEmpty() ||
+                           (version != 1 && session.pending.any());
+
+            // A full queue holds older frames; this one is skipped rather than queued behind
+            // them, the changes and the panel backlog stay pending
+            if(changed && full){
+                session.dropped++;
+            }
+            else if(changed){
+                this->takeDiff(session, diff);
+                session.sent++;
+                send = true;
+
+                if(!version){
+                    toggled = diff.signals ^ session.shownSignals;
+                    session.shownSignals = diff.signals;
+                }
+            }
+        }
+        xSemaphoreGive(this->machineMutex);
+
+        if(!send) continue;
+
+        if(version >= Protocol::DIFF_VERSION){
+            client->binary(frame, Protocol::encodeDiff(frame, sizeof(frame), diff));
         }
-        else if (type == "ping"){
-            Serial.println("[W_SERVER]: WebSocket Connection Active");
+        else if(version){
+            client->binary(frame, Protocol::encodePanel(frame, sizeof(frame), diff.panel));
         }
         else {
-            Serial.printf("[W_SERVER][ERROR]: Invalid message type: {%s}\n", type);
+            client->text(json, this->formatUpdateJson(diff, json, sizeof(json)));
+            this->sendSignalToggles(client, toggled, diff.signals);
         }
     }
+
+    xSemaphoreGive(this->clientMutex);
+
+    this->outbox = Protocol::Panel();
 }
 
 
-void W_Server::processPartialWebSocketData(StaticJsonDocument<512> doc) {
-    String field = doc["field"] | "";
+void W_Server::takeDiff(ClientSession &session, Protocol::Diff &diff)
+{
+    const W_Machine &machine = this->local.getMachine();
+    MachineChanges &pending = session.pending;
 
-    // Determine if value is int - display values or bool - signal lines
-    bool isBool = doc["value"].is<bool>();
-    bool boolValue = false;
-    int intValue = 0;
-    if (isBool) {
-        boolValue = doc["value"].as<bool>();
-        intValue = boolValue ? 1 : 0;
-    } else {
-        intValue = doc["value"].as<int>();
-        boolValue = (intValue != 0);
+    diff.registers = pending.registers;
+    for(uint8_t n = 0; n < Protocol::DIFF_REGISTERS; n++){
+        if(diff.registers & (1 << n)){
+            diff.values[n] = machine.getRegister(static_cast<W_Machine::Register>(n));
+        }
     }
 
-
-    //////////////////////////////////////// Display values ////////////////////////////////////////
-    if (field == "acc" && this->dispMan->acc){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: acc = %d\n", intValue);
-        this->dispMan->acc->displayValue(intValue);
+    diff.signals = machine.getSelectedSignals();
+
+    diff.lines = 0;
+    if(pending.buses & (1 << W_Machine::BUS_A)) diff.lines |= Protocol::LINE_BUS_A;
+    if(pending.buses & (1 << W_Machine::BUS_S)) diff.lines |= Protocol::LINE_BUS_S;
+    if(this->local.isStopLit())                 diff.lines |= Protocol::LINE_STOP;
+
+    diff.count = 0;
+    if(pending.memory.any()){
+        for(uint32_t address = 0; address < W_Machine::MEMORY_SIZE && diff.count < Protocol::DIFF_CELLS; address++){
+            if(pending.memory.test(address)){
+                diff.cells[diff.count].address = address;
+                diff.cells[diff.count].word = machine.getMemory(address);
+                diff.count++;
+                pending.memory.reset(address);
+            }
+        }
     }
-    else if (field == "a" && this->dispMan->a){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: a = %d\n", intValue);
-        this->dispMan->a->displayValue(intValue);
+
+    diff.panel = session.panel;
+    session.panel = Protocol::Panel();
+
+    pending.registers = 0;
+    pending.buses = 0;
+    pending.signals = false;
+}
+
+
+size_t W_Server::formatUpdateJson(const Protocol::Diff &diff, char *buffer, size_t size) const
+{
+    using Protocol::Field;
+
+    size_t length = 0;
+    auto append = [&](const char *format, auto... args){
+        if(length < size){
+            int written = snprintf(buffer + length, size - length, format, args...);
+            if(written > 0) length += written;
+        }
+        if(length >= size) length = size - 1;
+    };
+
+    auto nameOf = [](Signal signal){ return (signal == Signal::NONE) ? "TAKT" : Signals::name(signal); };
+
+    if(diff.panel.count > 0){
+        append("{\"type\":\"button_press\",\"buttonName\":\"%s\",\"buttons\":[", nameOf(diff.panel.buttons[0]));
+        for(uint8_t n = 0; n < diff.panel.count; n++){
+            append(n ? ",\"%s\"" : "\"%s\"", nameOf(diff.panel.buttons[n]));
+        }
+        append("],\"state\":{");
     }
-    else if (field == "s" && this->dispMan->s){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: s = %d\n", intValue);
-        this->dispMan->s->displayValue(intValue);
+    else {
+        append("{\"type\":\"state\",\"state\":{");
     }
-    else if (field == "c" && this->dispMan->c){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: c = %d\n", intValue);
-        this->dispMan->c->displayValue(intValue);
+
+    // Registers under their "reg-update" names
+    for(const Protocol::FieldName &entry : Protocol::JSON_FIELDS){
+        if(!Protocol::isRegister(entry.field)) continue;
+
+        W_Machine::Register reg = FIELD_REGISTERS[static_cast<uint8_t>(entry.field) - static_cast<uint8_t>(Field::AK)];
+        if(diff.registers & (1 << reg)){
+            append("\"%s\":%u,", entry.name, (unsigned)diff.values[reg]);
+        }
     }
-    else if (field == "i" && this->dispMan->i){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: i = %d\n", intValue);
-        this->dispMan->i->displayValue(intValue);
+    if(diff.registers & (1 << W_Machine::regJAML)){
+        append("\"jaml\":%u,", (unsigned)diff.values[W_Machine::regJAML]);
     }
 
-    ////////////////////////////////////////// PaO values //////////////////////////////////////////
-    else if (field == "addrs" && doc["addrs"].is<JsonArray>() && doc["args"].is<JsonArray>() && doc["vals"].is<JsonArray>() && this->dispMan->pao) {
-        JsonArray addrsArray = doc["addrs"].as<JsonArray>();
-        JsonArray argsArray = doc["args"].as<JsonArray>();
-        JsonArray valsArray = doc["vals"].as<JsonArray>();
-        for (size_t i = 0; i < 4; i++) {
-            int addr = addrsArray[i];
-            int arg = argsArray[i];
-            int val = valsArray[i];
-            Serial.print("[W_SERVER]: ");
-            Serial.printf("Partial update: pao[%d] addr: %d, arg: %d, val: %d\n", (int)i, addr, arg, val);
-            this->dispMan->pao[i]->displayLine(addr, val, arg);
-        }
-    }
-
-    //////////////////////////////////////// Signal values /////////////////////////////////////////
-    else if (field == "il" && this->dispMan->il){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: il = %d\n", boolValue);
-        this->dispMan->il->turnOnLine(boolValue);
+    append("\"signals\":[");
+    bool first = true;
+    for(const Protocol::FieldName &entry : Protocol::JSON_FIELDS){
+        if(Protocol::isSignal(entry.field) && (diff.signals & (1u << static_cast<uint8_t>(entry.field)))){
+            append(first ? "\"%s\"" : ",\"%s\"", entry.name);
+            first = false;
+        }
     }
-    else if (field == "wel" && this->dispMan->wel){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: wel = %d\n", boolValue);
-        this->dispMan->wel->turnOnLine(boolValue);
-    }
-    else if (field == "wyl" && this->dispMan->wyl){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: wyl = %d\n", boolValue);
-        this->dispMan->wyl->turnOnLine(boolValue);
-    }
-    else if (field == "wyad" && this->dispMan->wyad1 && this->dispMan->wyad2){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: wyad = %d\n", boolValue);
-        this->dispMan->wyad1->turnOnLine(boolValue);
-        this->dispMan->wyad2->turnOnLine(boolValue);
-    }
-    else if (field == "wei" && this->dispMan->wei){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: wei = %d\n", boolValue);
-        this->dispMan->wei->turnOnLine(boolValue);
-    }
-    else if (field == "weak" && this->dispMan->weak){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: weak = %d\n", boolValue);
-        this->dispMan->weak->turnOnLine(boolValue);
-    }
-    else if (field == "dod" && this->dispMan->dod){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: dod = %d\n", boolValue);
-        this->dispMan->dod->turnOnLine(boolValue);
-    }
-    else if (field == "ode" && this->dispMan->ode){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: ode = %d\n", boolValue);
-        this->dispMan->ode->turnOnLine(boolValue);
-    }
-    else if (field == "przep" && this->dispMan->przep){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: przep = %d\n", boolValue);
-        this->dispMan->przep->turnOnLine(boolValue);
-    }
-    else if (field == "weja" && this->dispMan->weja){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: weja = %d\n", boolValue);
-        this->dispMan->weja->turnOnLine(boolValue);
-    }
-    else if (field == "wyak" && this->dispMan->wyak){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: wyak = %d\n", boolValue);
-        this->dispMan->wyak->turnOnLine(boolValue);
-    }
-    else if (field == "wea" && this->dispMan->wea){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: wea = %d\n", boolValue);
-        this->dispMan->wea->turnOnLine(boolValue);
-    }
-    else if (field == "czyt" && this->dispMan->czyt){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: czyt = %d\n", boolValue);
-        this->dispMan->czyt->turnOnLine(boolValue);
-    }
-    else if (field == "pisz" && this->dispMan->pisz){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: pisz = %d\n", boolValue);
-        this->dispMan->pisz->turnOnLine(boolValue);
-    }
-    else if (field == "wes" && this->dispMan->wes){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: wes = %d\n", boolValue);
-        this->dispMan->wes->turnOnLine(boolValue);
-    }
-    else if (field == "wys" && this->dispMan->wys){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: wys = %d\n", boolValue);
-        this->dispMan->wys->turnOnLine(boolValue);
-    }
-    else if (field == "busA" && this->dispMan->busA){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: busA= %d\n", boolValue);
-        this->dispMan->busA->turnOnLine(boolValue);
-    }
-    else if (field == "busS" && this->dispMan->busS){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: busS= %d\n", boolValue);
-        this->dispMan->busS->turnOnLine(boolValue);
-    }
-    else if (field == "stop" && this->dispMan->stop){
-        Serial.print("[W_SERVER]: ");
-        Serial.printf("Partial update: stop= %d\n", boolValue);
-        this->dispMan->stop->turnOnLine(boolValue);
-    }
-}
-
-
-void W_Server::processFullWebSocketData(StaticJsonDocument<512> doc)
-{
-    //////////////////////////////////////// Full data update ////////////////////////////////////////
-    JsonObject dataObj = doc["data"];
-
-    if (dataObj.containsKey("acc") && this->dispMan->acc){
-        int accValue = dataObj["acc"];
-        Serial.print("[W_SERVER]: Received ACC value: ");
-        Serial.println(accValue);
-        this->dispMan->acc->displayValue(accValue);
-    }
-    if (dataObj.containsKey("a") && this->dispMan->a){
-        int aValue = dataObj["a"];
-        Serial.print("[W_SERVER]: Received A value: ");
-        Serial.println(aValue);
-        this->dispMan->a->displayValue(aValue);
-    }
-    if (dataObj.containsKey("s") && this->dispMan->s){
-        int sValue = dataObj["s"];
-        Serial.print("[W_SERVER]: Received S value: ");
-        Serial.println(sValue);
-        this->dispMan->s->displayValue(sValue);
-    }
-    if (dataObj.containsKey("c") && this->dispMan->c){
-        int cValue = dataObj["c"];
-        Serial.print("[W_SERVER]: Received C value: ");
-        Serial.println(cValue);
-        this->dispMan->c->displayValue(cValue);
-    }
-    if (dataObj.containsKey("i") && this->dispMan->i){
-        int iValue = dataObj["i"];
-        Serial.print("[W_SERVER]: Received I value: ");
-        Serial.println(iValue);
-        this->dispMan->i->displayValue(iValue);
-    }
-    if (dataObj["addrs"].is<JsonArray>() && dataObj["args"].is<JsonArray>() && dataObj["vals"].is<JsonArray>() && this->dispMan->pao){
-        JsonArray addrsArray = dataObj["addrs"].as<JsonArray>();
-        JsonArray argsArray = dataObj["args"].as<JsonArray>();
-        JsonArray valsArray = dataObj["vals"].as<JsonArray>();
-        for (size_t i = 0; i < 4; i++){
-            int addr = addrsArray[i];
-            int arg = argsArray[i];
-            int val = valsArray[i];
-            Serial.print("[W_SERVER]: ");
-            Serial.printf("addr: %d, arg: %d, val: %d\n", addr, arg, val);
+    append("]");
+
+    if(diff.lines & Protocol::LINE_BUS_A) append(",\"busA\":true");
+    if(diff.lines & Protocol::LINE_BUS_S) append(",\"busS\":true");
+    append(",\"stop\":%s", (diff.lines & Protocol::LINE_STOP) ? "true" : "false");
 
-            this->dispMan->pao[i]->displayLine(addr, val, arg);
+    if(diff.count > 0){
+        append(",\"mem\":[");
+        for(uint8_t n = 0; n < diff.count; n++){
+            append(n ? ",[%u,%u]" : "[%u,%u]", (unsigned)diff.cells[n].address, (unsigned)diff.cells[n].word);
         }
+        append("]");
     }
+    append("}}");
+
+    return length;
 }
 
 
-void W_Server::sendDataToClient(char *buttonNum){
-    StaticJsonDocument<256> doc;
-    doc["type"] = "button_press";
-    doc["buttonName"] = buttonNum;
+void W_Server::sendSignalToggles(AsyncWebSocketClient *client, SignalMask toggled, SignalMask selected)
+{
+    char json[64];
 
-    char jsonBuffer[256];
-    size_t len = serializeJson(doc, jsonBuffer);
+    for(const Protocol::FieldName &entry : Protocol::JSON_FIELDS){
+        SignalMask bit = 1u << static_cast<uint8_t>(entry.field);
+        if(!Protocol::isSignal(entry.field) || !(toggled & bit)) continue;
 
-    this->ws->textAll(jsonBuffer, len);
+        int length = snprintf(json, sizeof(json), "{\"type\":\"signal-toggle\",\"signal\":\"%s\",\"state\":%s}",
+                              entry.name, (selected & bit) ? "true" : "false");
+        client->text(json, length);
+    }
+}
+
+
+void W_Server::reportClientStats()
+{
+    unsigned long now = millis();
+    if(now - this->lastStatsTime < STATS_REPORT_MILLIS){
+        return;
+    }
+    this->lastStatsTime = now;
+
+    for(ClientSession &session : this->sessions){
+        // Copied under the lock and printed without it
+        xSemaphoreTake(this->machineMutex, portMAX_DELAY);
+        uint32_t id = session.id;
+        bool report = id && session.dropped != session.reportedDropped;
+        unsigned long sent = session.sent;
+        unsigned long dropped = session.dropped;
+        unsigned queueDepth = session.queueDepth;
+        unsigned maxQueueDepth = session.maxQueueDepth;
+        session.reportedDropped = session.dropped;
+        xSemaphoreGive(this->machineMutex);
+
+        if(!report) continue;
+
+        Serial.printf("[W_SERVER]: Client #%u sent %lu, dropped %lu frames, queue %u (max %u)\n",
+                      id, sent, dropped, queueDepth, maxQueueDepth);
+    }
 }
 
 
@@ -441,14 +876,12 @@ void W_Server::runningServerLED(){
 }
 
 
-void W_Server::sendSignalValue()
+void W_Server::collectPanelInput()
 {
-    char* signal = humInter->getPressedButton();
+    const PanelButton* signal = this->local.getPressedButton();
     if(this->lastSignal != signal){
-        if(signal != nullptr){
-            this->sendDataToClient(signal);
-            Serial.print("[W_SERVER]: Signal value sent: ");
-            Serial.println(String(signal).c_str());
+        if(signal != nullptr && this->outbox.count < Protocol::PANEL_BUTTONS){
+            this->outbox.buttons[this->outbox.count++] = signal->signal;
         }
         this->lastSignal = signal;
     }
@@ -465,6 +898,8 @@ void W_Server::handleLoadingAnimation()
             this->loading = false;
 
             this->dispMan->showIP(this->LOCAL_IP);
+            this->showingIP = true;
+            this->ipShownTime = millis();
         }
     } 
     else {
@@ -481,9 +916,9 @@ void W_Server::handleLoadingAnimation()
 }
 
 
-void W_Server::updateColors(StaticJsonDocument<512> doc)
+void W_Server::updateColors(const JsonDocument &doc)
 {
-    JsonObject data = doc["data"];
+    JsonObjectConst data = doc["data"];
 
     if(dispMan){
         if (data.isNull()) {
@@ -495,7 +930,7 @@ void W_Server::updateColors(StaticJsonDocument<512> doc)
             // if (n > 0) Serial.println(buf); else Serial.println("(<empty>)");
 
             Serial.println("[W_SERVER]: data contains keys:");
-            for (JsonPair kv : data) {
+            for (JsonPairConst kv : data) {
                 // Serialize value to string for safe printing
                 char vbuf[256];
                 size_t vn = serializeJson(kv.value(), vbuf, sizeof(vbuf));
@@ -603,10 +1038,16 @@ void W_Server::runServer()
     this->handleLoadingAnimation();
 
     if(WiFi.softAPgetStationNum() > 0){
-        this->sendSignalValue();
+        this->runMachine();
+        this->collectPanelInput();
+        this->publishUpdates();
+        this->reportClientStats();
     }
 
     this->runningServerLED();
 
-    this->dispMan->refreshDisplay();
+    // W_Local refreshes the display while the machine runs
+    if(this->loading || this->showingIP){
+        this->dispMan->refreshDisplay();
+    }
 }
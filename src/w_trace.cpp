@@ -0,0 +1,124 @@
+#include "w_trace.h"
+#include "w_machine.h"
+#include <stdio.h>
+
+namespace {
+    /// Register names, indexed by W_Machine::Register
+    const char *const REGISTER_NAMES[] = {"L", "I", "AK", "A", "S", "JAML"};
+
+    /// Bus names, indexed by W_Machine::Bus
+    const char *const BUS_NAMES[] = {"busA", "busS"};
+
+    static_assert(sizeof(REGISTER_NAMES) / sizeof(REGISTER_NAMES[0]) == W_Machine::REGISTER_COUNT, "W_Trace: register names out of sync");
+    static_assert(sizeof(BUS_NAMES) / sizeof(BUS_NAMES[0]) == W_Machine::BUS_COUNT, "W_Trace: bus names out of sync");
+}
+
+void W_Trace::record(const TraceEntry &entry)
+{
+    uint32_t index = this->head.load(std::memory_order_relaxed);
+
+    this->entries[index & (CAPACITY - 1)] = entry;
+    if(index == CAPACITY - 1){
+        this->filled.store(true, std::memory_order_relaxed);
+    }
+    this->head.store(index + 1, std::memory_order_release);
+}
+
+size_t W_Trace::read(Cursor &cursor, TraceEntry *out, size_t max) const
+{
+    uint32_t head = this->head.load(std::memory_order_acquire);
+
+    // The slot of entry head - CAPACITY may already be rewritten with entry head.
+    // Entry numbers wrap around, so they are compared by their signed distance.
+    int32_t overwritten = (int32_t)(head - cursor.next) - (int32_t)(CAPACITY - 1);
+    if(overwritten > 0){
+        cursor.dropped += overwritten;
+        cursor.next += overwritten;
+    }
+
+    uint32_t available = head - cursor.next;
+    size_t count = (available < max) ? available : max;
+
+    for(size_t n = 0; n < count; n++){
+        out[n] = this->entries[(cursor.next + n) & (CAPACITY - 1)];
+    }
+
+    // Entries the machine overwrote while they were copied are dropped
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint32_t after = this->head.load(std::memory_order_relaxed);
+    int32_t rewritten = (int32_t)(after - cursor.next) - (int32_t)(CAPACITY - 1);
+
+    size_t lost = 0;
+    if(rewritten > 0){
+        lost = ((size_t)rewritten < count) ? (size_t)rewritten : count;
+
+        for(size_t n = lost; n < count; n++){
+            out[n - lost] = out[n];
+        }
+        cursor.dropped += lost;
+    }
+
+    cursor.next += count;
+    return count - lost;
+}
+
+W_Trace::Cursor W_Trace::latest(uint32_t count) const
+{
+    uint32_t head = this->head.load(std::memory_order_acquire);
+
+    if(count > CAPACITY - 1) count = CAPACITY - 1;
+
+    // Before the ring first filled up, head is also the number of entries held
+    if(!this->filled.load(std::memory_order_relaxed) && count > head) count = head;
+
+    Cursor cursor;
+    cursor.next = head - count;
+    return cursor;
+}
+
+uint32_t W_Trace::getCount() const
+{
+    return this->head.load(std::memory_order_acquire);
+}
+
+size_t W_Trace::format(const TraceEntry &entry, uint32_t number, char *buffer, size_t size)
+{
+    if(size == 0){
+        return 0;
+    }
+
+    size_t length = 0;
+    auto append = [&](const char *format, auto... args){
+        if(length < size){
+            int written = snprintf(buffer + length, size - length, format, args...);
+            if(written > 0) length += written;
+        }
+        if(length >= size) length = size - 1;
+    };
+
+    append("#%lu", static_cast<unsigned long>(number));
+
+    // Signals in the order they were executed
+    for(Signal signal : Signals::EXECUTION_ORDER.signals){
+        if(entry.signals & Signals::bit(signal)) append(" %s", Signals::name(signal));
+    }
+
+    append(" |");
+    for(uint8_t reg = 0; reg < W_Machine::REGISTER_COUNT; reg++){
+        if(entry.registers & (1 << reg)) append(" %s", REGISTER_NAMES[reg]);
+    }
+
+    uint8_t buses = entry.flags >> TraceEntry::BUSES_SHIFT;
+    if(buses){
+        append(" |");
+        for(uint8_t bus = 0; bus < W_Machine::BUS_COUNT; bus++){
+            if(buses & (1 << bus)) append(" %s", BUS_NAMES[bus]);
+        }
+    }
+
+    if(entry.flags & TraceEntry::MEMORY_WRITTEN){
+        append(" | PAO[%u]=%u", static_cast<unsigned>(entry.address), static_cast<unsigned>(entry.value));
+    }
+
+    return length;
+}